@@ -0,0 +1,370 @@
+#ifndef EX6_CONCURRENTHASHMAP_HPP
+#define EX6_CONCURRENTHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <type_traits>
+#include <stdexcept>
+#include "HashMap.hpp"
+#include "HashMix.hpp"
+
+// -------------------------- const definitions -------------------------
+#define CONCURRENT_DEFAULT_SHARDS 64
+#define CACHE_LINE_SIZE 64
+
+// ------------------------------ functions -----------------------------
+/**
+ * thread safe HashMap containing KeyT and ValueT. the keys are split between independent HashMap
+ * shards by the high bits of their mixed hash, and every shard has its own reader/writer lock, so
+ * operations on different shards never wait for each other and a shard that resizes only blocks
+ * itself. values are returned by copy, since a reference would outlive the shard lock
+ */
+template<typename KeyT, typename ValueT>
+class ConcurrentHashMap
+{
+private:
+    /**
+     * a HashMap with its lock, padded so that the locks of neighbouring shards do not share a
+     * cache line
+     */
+    struct Shard
+    {
+        mutable std::shared_timed_mutex lock;
+        HashMap<KeyT, ValueT> map;
+        /**
+         * size of the map, readable without taking the lock
+         */
+        std::atomic<size_t> size{0};
+        char padding[CACHE_LINE_SIZE];
+    };
+
+    typedef std::shared_lock<std::shared_timed_mutex> ReadLock;
+    typedef std::unique_lock<std::shared_timed_mutex> WriteLock;
+
+    /**
+     * number of shards - a power of two
+     */
+    size_t _shardCount;
+    /**
+     * log2 of the number of shards
+     */
+    unsigned _shardBits;
+    /**
+     * the shards
+     */
+    std::unique_ptr<Shard[]> _shards;
+
+    /**
+     * @param key - a key
+     * @return the shard that holds the key
+     */
+    Shard &_shardOf(const KeyT &key) const noexcept
+    {
+        if (_shardBits == 0)
+        {
+            return _shards[0];
+        }
+        size_t hash = mixHash(std::hash<KeyT>{}(key));
+        return _shards[hash >> (sizeof(size_t) * 8 - _shardBits)];
+    }
+
+    /**
+     * publishes the size of a shard after a change, the shard's write lock must be held
+     * @param shard - the changed shard
+     */
+    static void _publishSize(Shard &shard) noexcept
+    {
+        shard.size.store(shard.map.size(), std::memory_order_relaxed);
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the ConcurrentHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty ConcurrentHashMap
+     * @param shardCount - number of shards, rounded up to a power of two
+     * @param policy - resize policy of every shard
+     */
+    explicit ConcurrentHashMap(size_t shardCount = CONCURRENT_DEFAULT_SHARDS,
+                               const HashMapPolicy &policy = HashMapPolicy{}) :
+            _shardCount(1), _shardBits(0)
+    {
+        while (_shardCount < shardCount)
+        {
+            _shardCount *= 2;
+            _shardBits++;
+        }
+        _shards.reset(new Shard[_shardCount]);
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            _shards[i].map.set_policy(policy);
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &other) = delete;
+
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &other) = delete;
+
+    /**
+     * @return number of shards
+     */
+    size_t shard_count() const noexcept
+    {
+        return _shardCount;
+    }
+
+    /**
+     * @return number of elements. taken shard by shard without locking, so while other threads
+     * write it is an estimate
+     */
+    size_t size() const noexcept
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            total += _shards[i].size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * @return true if the map is empty, an estimate while other threads write
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        WriteLock guard(shard.lock);
+        bool inserted = shard.map.try_emplace(key, val).second;
+        _publishSize(shard);
+        return inserted;
+    }
+
+    /**
+     * inserts a key with a value, or assigns the value if the key is already in the map
+     * @param key - the key
+     * @param val - the value
+     * @return true if the key was inserted
+     */
+    bool insert_or_assign(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        WriteLock guard(shard.lock);
+        bool inserted = shard.map.insert_or_assign(key, val).second;
+        _publishSize(shard);
+        return inserted;
+    }
+
+    /**
+     * inserts a key with init if it is not in the map yet, otherwise updates its value in place.
+     * only the key's shard is locked, and the key is looked up once
+     * @param key - the key
+     * @param init - value of the key if it is inserted
+     * @param fn - called with a ValueT & if the key is already in the map, under the shard lock
+     * @return a copy of the key's value after the update
+     */
+    template<typename Function>
+    ValueT upsert(const KeyT &key, const ValueT &init, Function fn) noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        WriteLock guard(shard.lock);
+        ValueT result = shard.map.upsert(key, init, fn);
+        _publishSize(shard);
+        return result;
+    }
+
+    /**
+     * updates the value of a key in place, if the key is in the map
+     * @param key - the key
+     * @param fn - called with a ValueT & if the key is in the map, under the shard lock
+     * @return true if the key is in the map
+     */
+    template<typename Function>
+    bool compute_if_present(const KeyT &key, Function fn) noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        WriteLock guard(shard.lock);
+        return shard.map.compute_if_present(key, fn);
+    }
+
+    /**
+     * atomically adds to the value of a key, inserting the key with delta if it is not in the map
+     * @param key - the key
+     * @param delta - the addend
+     * @return the value before the addition, ValueT() if the key was inserted
+     */
+    template<typename V = ValueT,
+             typename = typename std::enable_if<std::is_arithmetic<V>::value>::type>
+    ValueT fetch_add(const KeyT &key, ValueT delta) noexcept(false)
+    {
+        ValueT old = ValueT();
+        upsert(key, delta, [&old, delta](ValueT &val)
+               {
+                   old = val;
+                   val += delta;
+               });
+        return old;
+    }
+
+    /**
+     * the function gets a key and erases its value
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        WriteLock guard(shard.lock);
+        bool erased = shard.map.erase(key);
+        _publishSize(shard);
+        return erased;
+    }
+
+    /**
+     * the function checks if a certain key is in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        ReadLock guard(shard.lock);
+        return shard.map.contains_key(key);
+    }
+
+    /**
+     * the function gets a key and copies its value
+     * @param key - the key
+     * @param val - receives the value if the key is in the map
+     * @return true if the key is in the map
+     */
+    bool find(const KeyT &key, ValueT &val) const noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        ReadLock guard(shard.lock);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+        {
+            return false;
+        }
+        val = it->second;
+        return true;
+    }
+
+    /**
+     * the function gets a key and returns a copy of its value. in case the key is not in the map
+     * an exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT at(const KeyT &key) const noexcept(false)
+    {
+        Shard &shard = _shardOf(key);
+        ReadLock guard(shard.lock);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+        {
+            throw KeyNotFound{};
+        }
+        return it->second;
+    }
+
+    /**
+     * makes room for a number of elements, spread evenly over the shards
+     * @param elements - number of elements
+     */
+    void reserve(size_t elements) noexcept(false)
+    {
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            WriteLock guard(_shards[i].lock);
+            _shards[i].map.reserve(elements / _shardCount + 1);
+        }
+    }
+
+    /**
+     * sets the incremental rehash mode of every shard
+     * @param bucketsPerStep - buckets moved per operation, 0 rehashes in one go
+     */
+    void set_rehash_step(size_t bucketsPerStep) noexcept(false)
+    {
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            WriteLock guard(_shards[i].lock);
+            _shards[i].map.set_rehash_step(bucketsPerStep);
+        }
+    }
+
+    /**
+     * clears the map from all elements, one shard at a time
+     */
+    void clear() noexcept(false)
+    {
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            WriteLock guard(_shards[i].lock);
+            _shards[i].map.clear();
+            _publishSize(_shards[i]);
+        }
+    }
+
+    /**
+     * calls a function with every shard's map, holding the shard's read lock during the call.
+     * every shard is a consistent snapshot, but the shards are visited one after another
+     * @param fn - called with a const HashMap<KeyT, ValueT> &
+     */
+    template<typename Function>
+    void for_each_shard(Function fn) const noexcept(false)
+    {
+        for (size_t i = 0; i < _shardCount; i++)
+        {
+            ReadLock guard(_shards[i].lock);
+            fn(static_cast<const HashMap<KeyT, ValueT> &>(_shards[i].map));
+        }
+    }
+
+    /**
+     * calls a function with every element, shard by shard under the shard's read lock
+     * @param fn - called with a const pair<KeyT, ValueT> &
+     */
+    template<typename Function>
+    void for_each(Function fn) const noexcept(false)
+    {
+        for_each_shard([&fn](const HashMap<KeyT, ValueT> &map)
+                       {
+                           for (auto it = map.cbegin(); it != map.cend(); ++it)
+                           {
+                               fn(*it);
+                           }
+                       });
+    }
+};
+
+
+#endif //EX6_CONCURRENTHASHMAP_HPP
@@ -0,0 +1,287 @@
+#ifndef EX6_EPOCH_HPP
+#define EX6_EPOCH_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+
+// -------------------------- const definitions -------------------------
+#define EPOCH_MAX_THREADS 256
+#define EPOCH_SLOT_SIZE 64
+#define EPOCH_UNPINNED 0
+
+// ------------------------------ functions -----------------------------
+/**
+ * hands every thread a small index, used to pick its slot in an EpochDomain. indices of threads
+ * that exited are given to new threads
+ */
+class EpochThreadIndex
+{
+private:
+    /**
+     * the index of this thread
+     */
+    size_t _index;
+
+    /**
+     * @return lock of the index pool
+     */
+    static std::mutex &_poolLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    /**
+     * @return indices released by threads that exited
+     */
+    static std::vector<size_t> &_freeIndices()
+    {
+        static std::vector<size_t> indices;
+        return indices;
+    }
+
+    /**
+     * @return the next never used index
+     */
+    static size_t &_nextIndex()
+    {
+        static size_t next = 0;
+        return next;
+    }
+
+    EpochThreadIndex()
+    {
+        std::lock_guard<std::mutex> guard(_poolLock());
+        if (_freeIndices().empty())
+        {
+            _index = _nextIndex()++;
+        }
+        else
+        {
+            _index = _freeIndices().back();
+            _freeIndices().pop_back();
+        }
+    }
+
+    ~EpochThreadIndex()
+    {
+        std::lock_guard<std::mutex> guard(_poolLock());
+        _freeIndices().push_back(_index);
+    }
+
+public:
+    /**
+     * @return the index of the calling thread
+     */
+    static size_t current()
+    {
+        static thread_local EpochThreadIndex index;
+        return index._index;
+    }
+};
+
+/**
+ * epoch based reclamation. readers pin the current epoch in their own slot while they hold
+ * pointers to shared objects, writers retire unlinked objects with the epoch they were unlinked
+ * in, and an object is freed once every pinned reader started after it was retired. a reader only
+ * writes its own slot, so reading never writes a cache line shared with other threads
+ */
+class EpochDomain
+{
+private:
+    /**
+     * the epoch pinned by one thread, or EPOCH_UNPINNED. a slot fills a cache line so two threads
+     * never write the same line
+     */
+    struct Slot
+    {
+        std::atomic<size_t> epoch{EPOCH_UNPINNED};
+        char padding[EPOCH_SLOT_SIZE - sizeof(std::atomic<size_t>)];
+    };
+
+    /**
+     * an unlinked object waiting to be freed
+     */
+    struct Retired
+    {
+        void *object;
+        void (*deleter)(void *);
+        size_t epoch;
+    };
+
+    /**
+     * the global epoch, only advanced by writers
+     */
+    std::atomic<size_t> _epoch;
+    /**
+     * slot of each thread, by EpochThreadIndex
+     */
+    std::unique_ptr<Slot[]> _slots;
+    /**
+     * objects waiting to be freed, guarded by the writers' lock
+     */
+    std::vector<Retired> _retired;
+
+    /**
+     * frees an object of a given type
+     * @param object - the object
+     */
+    template<typename T>
+    static void _delete(void *object)
+    {
+        delete static_cast<T *>(object);
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if more than EPOCH_MAX_THREADS threads read at once
+     */
+    class TooManyThreads : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "too many reading threads";
+        }
+    };
+
+public:
+    /**
+     * keeps the calling thread pinned until it is destroyed
+     */
+    class Guard
+    {
+    private:
+        /**
+         * the pinned slot, nullptr if the thread was already pinned by an outer guard
+         */
+        Slot *_slot;
+
+    public:
+        explicit Guard(Slot *slot) noexcept : _slot(slot)
+        {
+        }
+
+        Guard(Guard &&other) noexcept : _slot(other._slot)
+        {
+            other._slot = nullptr;
+        }
+
+        Guard(const Guard &other) = delete;
+
+        Guard &operator=(const Guard &other) = delete;
+
+        ~Guard()
+        {
+            if (_slot != nullptr)
+            {
+                _slot->epoch.store(EPOCH_UNPINNED, std::memory_order_release);
+            }
+        }
+    };
+
+    EpochDomain() : _epoch(EPOCH_UNPINNED + 1), _slots(new Slot[EPOCH_MAX_THREADS])
+    {
+    }
+
+    EpochDomain(const EpochDomain &other) = delete;
+
+    EpochDomain &operator=(const EpochDomain &other) = delete;
+
+    /**
+     * frees every retired object, no reader may be pinned
+     */
+    ~EpochDomain()
+    {
+        for (const Retired &retired : _retired)
+        {
+            retired.deleter(retired.object);
+        }
+    }
+
+    /**
+     * pins the calling thread to the current epoch. objects reachable after this call are not
+     * freed before the returned guard is destroyed
+     * @return the guard of the pin
+     */
+    Guard pin() const noexcept(false)
+    {
+        size_t index = EpochThreadIndex::current();
+        if (index >= EPOCH_MAX_THREADS)
+        {
+            throw TooManyThreads{};
+        }
+        Slot &slot = _slots[index];
+        if (slot.epoch.load(std::memory_order_relaxed) != EPOCH_UNPINNED)
+        {
+            return Guard(nullptr);
+        }
+        // acquire pairs with the increment in reclaim: a reader that pins the new epoch sees every
+        // unlink made before it, so it can not reach an object retired in the epoch before
+        slot.epoch.store(_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return Guard(&slot);
+    }
+
+    /**
+     * retires an object that is no longer reachable by new readers. must be called under the
+     * writers' lock
+     * @param object - the unlinked object
+     */
+    template<typename T>
+    void retire(T *object) noexcept(false)
+    {
+        _retired.push_back({object, &_delete<T>, _epoch.load(std::memory_order_relaxed)});
+    }
+
+    /**
+     * @return number of retired objects that are not freed yet
+     */
+    size_t pending() const noexcept
+    {
+        return _retired.size();
+    }
+
+    /**
+     * advances the epoch and frees the retired objects no pinned reader can still see. must be
+     * called under the writers' lock
+     */
+    void reclaim() noexcept
+    {
+        if (_retired.empty())
+        {
+            return;
+        }
+        size_t oldest = _epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (size_t i = 0; i < EPOCH_MAX_THREADS; i++)
+        {
+            size_t pinned = _slots[i].epoch.load(std::memory_order_acquire);
+            if (pinned != EPOCH_UNPINNED && pinned < oldest)
+            {
+                oldest = pinned;
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < _retired.size(); i++)
+        {
+            if (_retired[i].epoch < oldest)
+            {
+                _retired[i].deleter(_retired[i].object);
+            }
+            else
+            {
+                _retired[kept++] = _retired[i];
+            }
+        }
+        _retired.resize(kept);
+    }
+};
+
+
+#endif //EX6_EPOCH_HPP
@@ -0,0 +1,851 @@
+#ifndef EX6_FLATHASHMAP_HPP
+#define EX6_FLATHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <memory>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
+#include "HashMix.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_USE_SSE2
+#endif
+
+// -------------------------- const definitions -------------------------
+#define FLAT_GROUP_WIDTH 16
+#define FLAT_DEFAULT_CAPACITY 16
+#define FLAT_MAX_LOAD_NUMERATOR 7
+#define FLAT_MAX_LOAD_DENOMINATOR 8
+#define FLAT_CTRL_EMPTY ((int8_t) -128)
+#define FLAT_CTRL_DELETED ((int8_t) -2)
+#define FLAT_FINGERPRINT_BITS 7
+
+// ------------------------------ functions -----------------------------
+/**
+ * @param mask - a non zero bitmask
+ * @return index of the lowest set bit of mask
+ */
+inline unsigned flatLowestBit(uint32_t mask) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned) __builtin_ctz(mask);
+#else
+    unsigned idx = 0;
+    while (!(mask & 1u))
+    {
+        mask >>= 1u;
+        idx++;
+    }
+    return idx;
+#endif
+}
+
+/**
+ * a group of FLAT_GROUP_WIDTH control bytes. a full slot holds the low 7 bits of its hash (a value
+ * in [0, 127]) while empty and deleted slots hold negative markers, so a whole group is matched
+ * against a fingerprint with a single compare
+ */
+class FlatGroup
+{
+#ifdef FLAT_USE_SSE2
+    /**
+     * the control bytes of the group
+     */
+    __m128i _ctrl;
+
+public:
+    /**
+     * loads a group starting at ctrl
+     * @param ctrl - pointer to FLAT_GROUP_WIDTH control bytes
+     */
+    explicit FlatGroup(const int8_t *ctrl) noexcept :
+            _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl)))
+    {}
+
+    /**
+     * @param h2 - a fingerprint or a control marker
+     * @return bitmask of the slots whose control byte equals h2
+     */
+    uint32_t match(int8_t h2) const noexcept
+    {
+        return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+    }
+
+    /**
+     * @return bitmask of the empty and deleted slots - the only control bytes with the sign bit set
+     */
+    uint32_t matchFree() const noexcept
+    {
+        return (uint32_t) _mm_movemask_epi8(_ctrl);
+    }
+#else
+    /**
+     * the control bytes of the group
+     */
+    const int8_t *_ctrl;
+
+public:
+    /**
+     * loads a group starting at ctrl
+     * @param ctrl - pointer to FLAT_GROUP_WIDTH control bytes
+     */
+    explicit FlatGroup(const int8_t *ctrl) noexcept : _ctrl(ctrl)
+    {}
+
+    /**
+     * @param h2 - a fingerprint or a control marker
+     * @return bitmask of the slots whose control byte equals h2
+     */
+    uint32_t match(int8_t h2) const noexcept
+    {
+        uint32_t mask = 0;
+        for (unsigned i = 0; i < FLAT_GROUP_WIDTH; i++)
+        {
+            if (_ctrl[i] == h2)
+            {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+    /**
+     * @return bitmask of the empty and deleted slots - the only control bytes with the sign bit set
+     */
+    uint32_t matchFree() const noexcept
+    {
+        uint32_t mask = 0;
+        for (unsigned i = 0; i < FLAT_GROUP_WIDTH; i++)
+        {
+            if (_ctrl[i] < 0)
+            {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+#endif
+
+    /**
+     * @return bitmask of the empty slots
+     */
+    uint32_t matchEmpty() const noexcept
+    {
+        return match(FLAT_CTRL_EMPTY);
+    }
+};
+
+/**
+ * open addressing HashMap containing KeyT and ValueT. the pairs are stored inline in one slot
+ * array next to a control byte array, and a lookup scans FLAT_GROUP_WIDTH control bytes at a time
+ * so most probes touch a single cache line and never follow a pointer. exposes the same interface
+ * as HashMap
+ */
+template<typename KeyT, typename ValueT>
+class FlatHashMap
+{
+public:
+    typedef std::pair<KeyT, ValueT> value_type;
+
+private:
+    /**
+     * number of slots - a power of two, at least FLAT_GROUP_WIDTH
+     */
+    size_t _capacity;
+    /**
+     * number of pairs in the map
+     */
+    size_t _size;
+    /**
+     * number of full and deleted slots - a deleted slot lengthens probes just like a full one
+     */
+    size_t _used;
+    /**
+     * control byte of every slot
+     */
+    int8_t *_ctrl;
+    /**
+     * the slots, only the ones with a non negative control byte hold a constructed pair
+     */
+    value_type *_slots;
+
+    /**
+     * @param capacity - number of slots
+     * @return how many slots may be used before the table has to grow
+     */
+    static size_t _maxUsed(size_t capacity) noexcept
+    {
+        return capacity / FLAT_MAX_LOAD_DENOMINATOR * FLAT_MAX_LOAD_NUMERATOR;
+    }
+
+    /**
+     * @param key - the key
+     * @return the mixed hash of the key
+     */
+    static size_t _hash(const KeyT &key) noexcept
+    {
+        return mixHash(std::hash<KeyT>{}(key));
+    }
+
+    /**
+     * @param hash - mixed hash of a key
+     * @return the fingerprint stored in the control byte
+     */
+    static int8_t _fingerprint(size_t hash) noexcept
+    {
+        return (int8_t) (hash & ((1u << FLAT_FINGERPRINT_BITS) - 1));
+    }
+
+    /**
+     * @param hash - mixed hash of a key
+     * @return the group the probe sequence of the hash starts in
+     */
+    size_t _firstGroup(size_t hash) const noexcept
+    {
+        return (hash >> FLAT_FINGERPRINT_BITS) & _groupMask();
+    }
+
+    /**
+     * @return mask of group indices
+     */
+    size_t _groupMask() const noexcept
+    {
+        return _capacity / FLAT_GROUP_WIDTH - 1;
+    }
+
+    /**
+     * allocates an empty table
+     * @param capacity - number of slots
+     */
+    void _allocate(size_t capacity) noexcept(false)
+    {
+        _slots = std::allocator<value_type>().allocate(capacity);
+        try
+        {
+            _ctrl = new int8_t[capacity];
+        }
+        catch (...)
+        {
+            std::allocator<value_type>().deallocate(_slots, capacity);
+            throw;
+        }
+        std::memset(_ctrl, FLAT_CTRL_EMPTY, capacity);
+        _capacity = capacity;
+        _used = 0;
+    }
+
+    /**
+     * destroys all pairs and frees the table
+     */
+    void _release() noexcept
+    {
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_ctrl[i] >= 0)
+            {
+                _slots[i].~value_type();
+            }
+        }
+        delete[] _ctrl;
+        std::allocator<value_type>().deallocate(_slots, _capacity);
+    }
+
+    /**
+     * @param key - the key we are looking for
+     * @param hash - mixed hash of the key
+     * @return slot index of the key, or capacity() if the key is not in the map
+     */
+    size_t _find(const KeyT &key, size_t hash) const noexcept
+    {
+        const int8_t h2 = _fingerprint(hash);
+        size_t group = _firstGroup(hash);
+        for (size_t step = 1;; step++)
+        {
+            FlatGroup ctrl(_ctrl + group * FLAT_GROUP_WIDTH);
+            for (uint32_t match = ctrl.match(h2); match; match &= match - 1)
+            {
+                size_t idx = group * FLAT_GROUP_WIDTH + flatLowestBit(match);
+                if (_slots[idx].first == key)
+                {
+                    return idx;
+                }
+            }
+            if (ctrl.matchEmpty())
+            {
+                return _capacity;
+            }
+            // triangular steps visit every group of a power of two table
+            group = (group + step) & _groupMask();
+        }
+    }
+
+    /**
+     * @param hash - mixed hash of a key
+     * @return the first empty or deleted slot on the probe sequence of the hash
+     */
+    size_t _findFree(size_t hash) const noexcept
+    {
+        size_t group = _firstGroup(hash);
+        for (size_t step = 1;; step++)
+        {
+            uint32_t free = FlatGroup(_ctrl + group * FLAT_GROUP_WIDTH).matchFree();
+            if (free)
+            {
+                return group * FLAT_GROUP_WIDTH + flatLowestBit(free);
+            }
+            group = (group + step) & _groupMask();
+        }
+    }
+
+    /**
+     * moves all pairs to a new table, which also drops every deleted marker
+     * @param newCapacity - the capacity after resizing
+     */
+    void _rehash(size_t newCapacity) noexcept(false)
+    {
+        int8_t *oldCtrl = _ctrl;
+        value_type *oldSlots = _slots;
+        size_t oldCapacity = _capacity;
+        _allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                size_t hash = _hash(oldSlots[i].first);
+                size_t idx = _findFree(hash);
+                ::new((void *) (_slots + idx)) value_type(std::move(oldSlots[i]));
+                _ctrl[idx] = _fingerprint(hash);
+                oldSlots[i].~value_type();
+            }
+        }
+        _used = _size;
+        delete[] oldCtrl;
+        std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+    }
+
+    /**
+     * finds a slot for a new key, growing the table if needed
+     * @param hash - mixed hash of the new key
+     * @return index of the slot the key should be constructed in
+     */
+    size_t _prepareInsert(size_t hash) noexcept(false)
+    {
+        size_t idx = _findFree(hash);
+        if (_ctrl[idx] == FLAT_CTRL_EMPTY && _used + 1 > _maxUsed(_capacity))
+        {
+            // mostly deleted markers - cleaning them up in place is enough
+            _rehash(_size + 1 <= _maxUsed(_capacity) / 2 ? _capacity : _capacity * 2);
+            idx = _findFree(hash);
+        }
+        return idx;
+    }
+
+    /**
+     * marks a slot that was returned by _prepareInsert as full, after its pair was constructed
+     * @param idx - slot index
+     * @param hash - mixed hash of the key in the slot
+     */
+    void _commitInsert(size_t idx, size_t hash) noexcept
+    {
+        if (_ctrl[idx] == FLAT_CTRL_EMPTY)
+        {
+            _used++;
+        }
+        _ctrl[idx] = _fingerprint(hash);
+        _size++;
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the FlatHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+    /**
+     * exception thrown if given vectors do not have the same size
+     */
+    class VectorsLength : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "the vectors do not have same size";
+        }
+    };
+
+public:
+    /**
+     * default constructor of FlatHashMap
+     */
+    FlatHashMap() : _capacity(0), _size(0), _used(0), _ctrl(nullptr), _slots(nullptr)
+    {
+        _allocate(FLAT_DEFAULT_CAPACITY);
+    }
+
+    /**
+     * a constructor that gets an iterator for keys and iterator for values and constructs a
+     * FlatHashMap with matching pairs, a repeated key keeps its last value
+     * @tparam KeysInputIterator - type of keys iterator
+     * @tparam ValuesInputIterator - type of values iterator
+     * @param keysBegin - beginning of keys iterator
+     * @param keysEnd - end of keys iterator
+     * @param valuesBegin - beginning of values iterator
+     * @param valuesEnd - end of values iterator
+     */
+    template<typename KeysInputIterator, typename ValuesInputIterator>
+    FlatHashMap(const KeysInputIterator keysBegin, const KeysInputIterator keysEnd,
+                const ValuesInputIterator valuesBegin, const ValuesInputIterator valuesEnd) :
+            FlatHashMap()
+    {
+        if (std::distance(keysBegin, keysEnd) - std::distance(valuesBegin, valuesEnd))
+        {
+            throw VectorsLength{};
+        }
+        auto it2 = valuesBegin;
+        for (auto it1 = keysBegin; it1 != keysEnd; it1++, it2++)
+        {
+            if (!insert(*it1, *it2))
+            {
+                at(*it1) = *it2;
+            }
+        }
+    }
+
+    /**
+     * copy constructor
+     * @param other - FlatHashMap to copy from
+     */
+    FlatHashMap(const FlatHashMap &other) : _capacity(0), _size(0), _used(0), _ctrl(nullptr),
+                                            _slots(nullptr)
+    {
+        _allocate(other._capacity);
+        for (size_t i = 0; i < other._capacity; i++)
+        {
+            if (other._ctrl[i] >= 0)
+            {
+                try
+                {
+                    ::new((void *) (_slots + i)) value_type(other._slots[i]);
+                }
+                catch (...)
+                {
+                    _release();
+                    throw;
+                }
+                _ctrl[i] = other._ctrl[i];
+            }
+        }
+        std::memcpy(_ctrl, other._ctrl, _capacity);
+        _size = other._size;
+        _used = other._used;
+    }
+
+    /**
+     * FlatHashMap destructor
+     */
+    ~FlatHashMap()
+    {
+        _release();
+    }
+
+    /**
+     * @return size of the map
+     */
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * @return current capacity of the map
+     */
+    size_t capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    /**
+     * @return true if map is empty
+     */
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /**
+     * @return current load factor
+     */
+    double load_factor() const noexcept
+    {
+        return (double) size() / capacity();
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        size_t hash = _hash(key);
+        if (_find(key, hash) != _capacity)
+        {
+            return false;
+        }
+        size_t idx = _prepareInsert(hash);
+        ::new((void *) (_slots + idx)) value_type(key, val);
+        _commitInsert(idx, hash);
+        return true;
+    }
+
+    /**
+     * the function checks if a certain key is already in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept
+    {
+        return _find(key, _hash(key)) != _capacity;
+    }
+
+    /**
+     * const version of the function - the function gets a key and returns its value. in case the
+     * key is not in the map an exception is thrown.
+     * @param key - the key
+     * @return - key's value
+     */
+    const ValueT &at(const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key, _hash(key));
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * the function gets a key and returns its value. in case the key is not in the map an
+     * exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT &at(const KeyT &key) noexcept(false)
+    {
+        size_t idx = _find(key, _hash(key));
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * the function gets a key and erases its value. the slot becomes empty if its group still has
+     * an empty slot (no probe sequence can pass through such a group), otherwise it is marked as
+     * deleted until the next rehash
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept
+    {
+        size_t idx = _find(key, _hash(key));
+        if (idx == _capacity)
+        {
+            return false;
+        }
+        _slots[idx].~value_type();
+        size_t group = idx & ~((size_t) FLAT_GROUP_WIDTH - 1);
+        if (FlatGroup(_ctrl + group).matchEmpty())
+        {
+            _ctrl[idx] = FLAT_CTRL_EMPTY;
+            _used--;
+        }
+        else
+        {
+            _ctrl[idx] = FLAT_CTRL_DELETED;
+        }
+        _size--;
+        return true;
+    }
+
+    /**
+     * the function gets a key and returns it's bucket size - a slot holds a single pair. the
+     * function throws an exception if the key was not found
+     * @param key - the key
+     * @return - size of bucket
+     */
+    size_t bucket_size(const KeyT &key) const noexcept(false)
+    {
+        bucket_index(key);
+        return 1;
+    }
+
+    /**
+     * the function gets a key and returns the index of its slot if the map contains the key, or
+     * throws an exception if not
+     * @param key - the key
+     * @return - slot index
+     */
+    size_t bucket_index(const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key, _hash(key));
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return idx;
+    }
+
+    /**
+     * the function clears the map from all elements, the capacity is kept
+     */
+    void clear() noexcept
+    {
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_ctrl[i] >= 0)
+            {
+                _slots[i].~value_type();
+            }
+        }
+        std::memset(_ctrl, FLAT_CTRL_EMPTY, _capacity);
+        _size = 0;
+        _used = 0;
+    }
+
+    /**
+     * assignment operator
+     * @param other - map to copy elements from
+     * @return reference to FlatHashMap
+     */
+    FlatHashMap &operator=(const FlatHashMap &other) noexcept(false)
+    {
+        if (this != &other)
+        {
+            FlatHashMap copy(other);
+            std::swap(_capacity, copy._capacity);
+            std::swap(_size, copy._size);
+            std::swap(_used, copy._used);
+            std::swap(_ctrl, copy._ctrl);
+            std::swap(_slots, copy._slots);
+        }
+        return *this;
+    }
+
+    /**
+     * subscript operator, inserts a default value if the key is not in the map
+     * @param key - the key
+     * @return reference to the key's value
+     */
+    ValueT &operator[](const KeyT &key) noexcept(false)
+    {
+        size_t hash = _hash(key);
+        size_t idx = _find(key, hash);
+        if (idx == _capacity)
+        {
+            idx = _prepareInsert(hash);
+            ::new((void *) (_slots + idx)) value_type(key, ValueT());
+            _commitInsert(idx, hash);
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * subscript operator
+     * @param key - the key
+     * @return the key's value, or a default value if the key is not in the map
+     */
+    ValueT operator[](const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key, _hash(key));
+        return idx == _capacity ? ValueT() : _slots[idx].second;
+    }
+
+    /**
+     * checks if two maps are identical
+     * @param other - another map
+     * @return true if they are
+     */
+    bool operator==(const FlatHashMap &other) const noexcept
+    {
+        if (this->capacity() != other.capacity() || this->size() != other.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_ctrl[i] >= 0)
+            {
+                size_t idx = other._find(_slots[i].first, _hash(_slots[i].first));
+                if (idx == other._capacity || !(other._slots[idx].second == _slots[i].second))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * checks if two maps are not identical
+     * @param other - another map
+     * @return true if they are different
+     */
+    bool operator!=(const FlatHashMap &other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+// -------------------------- iterator class -------------------------
+
+    /**
+     * class of a const iterator for FlatHashMap
+     */
+    class ConstIterator
+    {
+        const FlatHashMap *_map;
+        size_t _index;
+
+        /**
+         * moves forward to the first full slot at or after the current one, skipping whole
+         * groups of free slots
+         */
+        void _skipFree() noexcept
+        {
+            while (_index < _map->_capacity && _map->_ctrl[_index] < 0)
+            {
+                if (_index % FLAT_GROUP_WIDTH == 0)
+                {
+                    uint32_t full = ~FlatGroup(_map->_ctrl + _index).matchFree() &
+                                    ((1u << FLAT_GROUP_WIDTH) - 1);
+                    _index += full ? flatLowestBit(full) : FLAT_GROUP_WIDTH;
+                }
+                else
+                {
+                    _index++;
+                }
+            }
+        }
+
+    public:
+        /**
+         * iterator traits:
+         */
+        typedef std::pair<KeyT, ValueT> value_type;
+        typedef const std::pair<KeyT, ValueT> *pointer;
+        typedef const std::pair<KeyT, ValueT> &reference;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::forward_iterator_tag iterator_category;
+
+        ConstIterator() : _map(nullptr), _index(0)
+        {}
+
+        /**
+         * const iterator constructor
+         * @param map - the iterated map
+         * @param index - slot to start from, the iterator moves to the first full slot from it
+         */
+        ConstIterator(const FlatHashMap *map, size_t index) : _map(map), _index(index)
+        {
+            _skipFree();
+        }
+
+        /**
+         * @return the element pointed to by the iterator
+         */
+        reference operator*() const
+        {
+            return _map->_slots[_index];
+        }
+
+        /**
+         * @return pointer to the element pointed to by the iterator
+         */
+        pointer operator->() const
+        {
+            return _map->_slots + _index;
+        }
+
+        /**
+         * prefix increment operator
+         * @return
+         */
+        ConstIterator &operator++()
+        {
+            _index++;
+            _skipFree();
+            return *this;
+        }
+
+        /**
+         * postfix increment operator
+         * @return
+         */
+        ConstIterator operator++(int)
+        {
+            ConstIterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * equal operator
+         * @param other - other iterator
+         * @return true if iterators are the same
+         */
+        bool operator==(const ConstIterator &other) const
+        {
+            return this->_map == other._map && this->_index == other._index;
+        }
+
+        /**
+         * not equal operator
+         * @param other - other iterator
+         * @return true if iterators are not the same
+         */
+        bool operator!=(const ConstIterator &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    typedef ConstIterator const_iterator;
+    typedef ConstIterator iterator;
+
+    const_iterator begin() const
+    {
+        return ConstIterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return ConstIterator(this, _capacity);
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+};
+
+
+#endif //EX6_FLATHASHMAP_HPP
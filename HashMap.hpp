@@ -3,30 +3,311 @@
 
 // ------------------------------ includes ------------------------------
 #include <cstdlib>
+#include <cstdint>
 #include <utility>
+#include <algorithm>
 #include <list>
+#include <tuple>
+#include <iterator>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#include "HashMix.hpp"
+#include "NodePool.hpp"
 
 // -------------------------- const definitions -------------------------
 #define DEFAULT_CAPACITY 16
 #define MINIMAL_CAPACITY 1
 #define LOW_LOAD_FACTOR 0.25
 #define HIGH_LOAD_FACTOR 0.75
+#define PREFETCH_GROUP_SIZE 32
+#define PARALLEL_BUCKET_GRAIN 1024
+#define PARALLEL_REDUCE_BLOCKS 256
+#define OCCUPANCY_WORD_BITS 64
+#define MAX_CHAIN_LENGTH 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HASHMAP_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define HASHMAP_PREFETCH(address) ((void) (address))
+#endif
 
 // -------------------------- namespaces definitions -------------------------
 using std::list;
 using std::pair;
-template<typename KeyT, typename ValueT> using bucket = list<pair<KeyT, ValueT>>;
+template<typename KeyT, typename ValueT, typename Allocator = std::allocator<pair<KeyT, ValueT>>>
+using bucket = list<pair<KeyT, ValueT>, typename std::allocator_traits<Allocator>::template
+        rebind_alloc<pair<KeyT, ValueT>>>;
 
 // ------------------------------ functions -----------------------------
+/**
+ * @param word - a non zero word
+ * @return index of the lowest set bit of word
+ */
+inline unsigned hashMapLowestBit(uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned) __builtin_ctzll(word);
+#else
+    unsigned idx = 0;
+    while (!(word & 1u))
+    {
+        word >>= 1u;
+        idx++;
+    }
+    return idx;
+#endif
+}
+
+/**
+ * bit mixing applied to the Hash of a key before the low bits of the result pick its bucket
+ */
+enum class HashMapFinalizer
+{
+    /**
+     * the hash is used as it is, for hashes that are already spread over the low bits
+     */
+    IDENTITY,
+    /**
+     * fibonacciHash, a multiply and a shift
+     */
+    FIBONACCI,
+    /**
+     * mixHash, the murmur3 finalizer
+     */
+    MURMUR,
+    /**
+     * sipHashOf the key itself, with a random key of the map. for keys that come from outside:
+     * their collisions can not be planned, and a chain that still grows past the policy's
+     * maxChainLength makes the map draw a new key and rehash
+     */
+    SIPHASH
+};
+
+/**
+ * resize policy of a HashMap
+ */
+struct HashMapPolicy
+{
+    /**
+     * the table grows when the load factor passes it
+     */
+    double maxLoadFactor = HIGH_LOAD_FACTOR;
+    /**
+     * the table shrinks when the load factor drops under it, 0 never shrinks
+     */
+    double minLoadFactor = LOW_LOAD_FACTOR;
+    /**
+     * the capacity is multiplied by it when growing and divided by it when shrinking, a power of
+     * two of at least 2
+     */
+    size_t growthFactor = 2;
+    /**
+     * number of erases in a row (with no insert between them) that must leave the load factor
+     * under minLoadFactor before the table shrinks, at least 1
+     */
+    size_t shrinkHysteresis = 1;
+    /**
+     * mixing of the key hashes. std::hash of an integer is the integer itself, so with the
+     * identity keys with a stride that is a multiple of the capacity share a bucket
+     */
+    HashMapFinalizer finalizer = HashMapFinalizer::IDENTITY;
+    /**
+     * with the SIPHASH finalizer, an insert into a bucket that then holds more elements draws a
+     * new key and rehashes the map (at most once per doubling of its size)
+     */
+    size_t maxChainLength = MAX_CHAIN_LENGTH;
+};
+
+/**
+ * holds a hash function, key comparison or allocator of a HashMap. an empty one is a base class
+ * instead of a member, so it takes no space (the empty base optimization)
+ * @tparam T - the held type
+ * @tparam Tag - tells apart the holders of a map, which may hold the same type
+ */
+template<typename T, int Tag, bool Empty = std::is_empty<T>::value && !std::is_final<T>::value>
+class HashMapMember : private T
+{
+public:
+    HashMapMember() = default;
+
+    explicit HashMapMember(const T &value) : T(value)
+    {}
+
+    T &get() noexcept
+    {
+        return *this;
+    }
+
+    const T &get() const noexcept
+    {
+        return *this;
+    }
+};
+
+template<typename T, int Tag>
+class HashMapMember<T, Tag, false>
+{
+private:
+    T _value;
+
+public:
+    HashMapMember() = default;
+
+    explicit HashMapMember(const T &value) : _value(value)
+    {}
+
+    T &get() noexcept
+    {
+        return _value;
+    }
+
+    const T &get() const noexcept
+    {
+        return _value;
+    }
+};
+
+/**
+ * tells if a hash function or key comparison takes other types than the key type, which it shows
+ * with an is_transparent member type
+ */
+template<typename T, typename = void>
+struct HashMapIsTransparent : std::false_type
+{
+};
+
+template<typename T>
+struct HashMapIsTransparent<T, typename std::conditional<true, void,
+        typename T::is_transparent>::type> : std::true_type
+{
+};
+
+/**
+ * @return false, an allocator is taken to give each node's memory back when it is freed
+ */
+template<typename Allocator>
+bool hashMapMonotonic(const Allocator &) noexcept
+{
+    return false;
+}
+
+#if __cplusplus >= 201703L
+
+/**
+ * @param allocator - a polymorphic allocator
+ * @return true if its memory resource is a monotonic_buffer_resource, which gives memory back only
+ * once it is released or destroyed, so freeing a node does nothing
+ */
+template<typename T>
+bool hashMapMonotonic(const std::pmr::polymorphic_allocator<T> &allocator) noexcept
+{
+    return dynamic_cast<std::pmr::monotonic_buffer_resource *>(allocator.resource()) != nullptr;
+}
+
+#endif
+
+/**
+ * @return true if several threads may allocate and free through copies of an allocator at once.
+ * taken to hold for an allocator that is always equal to its copies, such as std::allocator,
+ * which has no state of its own to race on
+ */
+template<typename Allocator>
+bool hashMapConcurrent(const Allocator &) noexcept
+{
+    return std::allocator_traits<Allocator>::is_always_equal::value;
+}
+
+/**
+ * @return true, a node pool is guarded by a lock
+ */
+template<typename T>
+bool hashMapConcurrent(const NodePoolAllocator<T> &) noexcept
+{
+    return true;
+}
+
+#if __cplusplus >= 201703L
+
+/**
+ * @param allocator - a polymorphic allocator
+ * @return true if its memory resource is the new_delete_resource or a synchronized_pool_resource.
+ * the other standard resources, and any resource this can not tell about, are not thread safe
+ */
+template<typename T>
+bool hashMapConcurrent(const std::pmr::polymorphic_allocator<T> &allocator) noexcept
+{
+    return allocator.resource() == std::pmr::new_delete_resource() ||
+           dynamic_cast<std::pmr::synchronized_pool_resource *>(allocator.resource()) != nullptr;
+}
+
+#endif
+
+/**
+ * gives the memory an allocator keeps back, once a map emptied or destroyed its table. nothing for
+ * an allocator that keeps nothing
+ */
+template<typename Allocator>
+void hashMapRelease(const Allocator &) noexcept
+{}
+
+/**
+ * frees the chunks of the allocator's pool that hold no block in use, so a small table of the map
+ * or the nodes of another map of the pool only keep their own chunks
+ * @param allocator - a node pool allocator
+ */
+template<typename T>
+void hashMapRelease(const NodePoolAllocator<T> &allocator) noexcept
+{
+    allocator.pool().release();
+}
+
 /**
  * class of HashMap containing KeyT and ValueT
+ * @tparam Hash - hash function of the keys
+ * @tparam KeyEqual - equality of the keys, keys it finds equal must have equal hashes
+ * @tparam Allocator - allocates the bucket tables and the list nodes, rebound to each
  */
-template<typename KeyT, typename ValueT>
-class HashMap
+template<typename KeyT, typename ValueT, typename Hash = std::hash<KeyT>,
+        typename KeyEqual = std::equal_to<KeyT>,
+        typename Allocator = std::allocator<pair<KeyT, ValueT>>>
+class HashMap : private HashMapMember<Hash, 0>, private HashMapMember<KeyEqual, 1>,
+                private HashMapMember<Allocator, 2>
 {
 private:
+    typedef bucket<KeyT, ValueT, Allocator> Bucket;
+    typedef typename Bucket::allocator_type NodeAllocator;
+    typedef std::allocator_traits<Allocator> AllocatorTraits;
+    typedef typename AllocatorTraits::template rebind_alloc<Bucket> BucketAllocator;
+    typedef typename AllocatorTraits::template rebind_alloc<uint64_t> WordAllocator;
+    typedef std::vector<uint64_t, WordAllocator> OccupancyBits;
+    /**
+     * true for an allocator that moves on move assignment but not on swap
+     */
+    typedef std::integral_constant<bool,
+            AllocatorTraits::propagate_on_container_move_assignment::value &&
+            !AllocatorTraits::propagate_on_container_swap::value> MovesOnlyOnAssignment;
+    typedef typename Bucket::iterator NodeIterator;
+    typedef typename Bucket::const_iterator ConstNodeIterator;
+
+    /**
+     * enables a lookup overload taking a K instead of a KeyT, when Hash and KeyEqual are both
+     * transparent. such a lookup hashes and compares the K itself and constructs no key
+     */
+    template<typename K>
+    using TransparentKey = typename std::enable_if<HashMapIsTransparent<Hash>::value &&
+                                                   HashMapIsTransparent<KeyEqual>::value, K>::type;
+
     /**
      * capacity of HashMap
      */
@@ -38,14 +319,67 @@ private:
     /**
     * pointer to lists of pairs containing the HashMap elements
     */
-    bucket<KeyT, ValueT> *_hashTable;
+    Bucket *_hashTable;
+    /**
+     * the single empty bucket _hashTable points to while the map holds no table of its own, so
+     * moving from a map does not allocate. it is the map's own, constructed with the map's
+     * allocator, so no map reads a bucket whose allocator belongs to another map
+     */
+    Bucket _emptyBucket;
+    /**
+     * while an incremental rehash is in progress - the table the elements are moved from,
+     * otherwise nullptr
+     */
+    Bucket *_oldTable;
+    /**
+     * capacity of the old table, 0 when no incremental rehash is in progress
+     */
+    size_t _oldCapacity;
+    /**
+     * number of old table buckets that were already moved to the new table
+     */
+    size_t _migrated;
+    /**
+     * number of buckets moved on each insert, erase and at while an incremental rehash is in
+     * progress, 0 rehashes in one go
+     */
+    size_t _rehashStep;
+    /**
+     * resize policy
+     */
+    HashMapPolicy _policy;
+    /**
+     * the table never shrinks under this capacity, set by reserve
+     */
+    size_t _minCapacity;
+    /**
+     * number of erases in a row that left the load factor under the policy's minimum
+     */
+    size_t _lowLoadErases;
+    /**
+     * one bit per bucket of the table, set if the bucket is not empty, so iteration skips empty
+     * buckets a word at a time. empty for the empty table. it comes from the map's allocator too
+     */
+    OccupancyBits _occupied;
+    /**
+     * the same for the old table while an incremental rehash is in progress
+     */
+    OccupancyBits _oldOccupied;
+    /**
+     * key of the SIPHASH finalizer
+     */
+    SipKey _seed;
+    /**
+     * a long chain only makes the map draw a new key once it holds more elements than this
+     */
+    size_t _reseedFloor;
 
     /**
      * @return true if we will pass the high load factor after adding an item to the hashMap
      */
     bool _upperLoadFactor() const noexcept
     {
-        return load_factor() > HIGH_LOAD_FACTOR;
+        return load_factor() > _policy.maxLoadFactor;
     }
 
     /**
@@ -53,576 +387,2751 @@ private:
      */
     bool _lowerLoadFactor() const noexcept
     {
-        return load_factor() < LOW_LOAD_FACTOR;
+        return load_factor() < _policy.minLoadFactor;
     }
 
     /**
-     * creates a new hashTable and transfers all items from the old one, also deletes the old
-     * hashTable
-     * @param newCapacity - the capacity after resizing
+     * @return the capacity the table may shrink to
      */
-    void _rehash(size_t newCapacity) noexcept(false)
+    size_t _shrinkFloor() const noexcept
     {
-        auto *newMap = new bucket<KeyT, ValueT>[newCapacity];
-        for (size_t i = 0; i < capacity(); i++)
-        {
-            for (auto tuple: _hashTable[i])
-            {
-                size_t idx = std::hash<KeyT>{}(tuple.first) & (newCapacity - 1);
-                newMap[idx].push_back(pair<KeyT, ValueT>{tuple.first, tuple.second});
-            }
-        }
-        delete[] _hashTable;
-        _hashTable = newMap;
-        _capacity = newCapacity;
+        return _minCapacity > MINIMAL_CAPACITY ? _minCapacity : MINIMAL_CAPACITY;
     }
 
     /**
-     * @param key - the key we want to add
-     * @return an index according to the wanted hash function
+     * @param elements - number of elements
+     * @return the smallest capacity that holds the elements without passing the maximal load
+     * factor
      */
-    size_t _hash(const KeyT &key) const noexcept
+    size_t _fitCapacity(size_t elements) const noexcept
     {
-        return std::hash<KeyT>{}(key) & (capacity() - 1);
+        size_t newCapacity = MINIMAL_CAPACITY;
+        while (elements > newCapacity * _policy.maxLoadFactor)
+        {
+            newCapacity *= 2;
+        }
+        return newCapacity;
     }
 
-    // -------------------------- exception classes -------------------------
-
     /**
-     * exception thrown if a given key is not found in the HashMap
+     * @param policy - a resize policy
+     * @return the policy if it is valid, throws an exception otherwise
      */
-    class KeyNotFound : public std::exception
+    static const HashMapPolicy &_checkPolicy(const HashMapPolicy &policy) noexcept(false)
     {
-        virtual const char *what() const noexcept
+        // the load right after growing must stay over the shrinking point, or the table thrashes
+        if (!(policy.maxLoadFactor > 0) || policy.growthFactor < 2 ||
+            (policy.growthFactor & (policy.growthFactor - 1)) || policy.minLoadFactor < 0 ||
+            policy.minLoadFactor >= policy.maxLoadFactor / policy.growthFactor ||
+            policy.shrinkHysteresis == 0 || policy.maxChainLength == 0)
         {
-            return "key is not found";
+            throw InvalidPolicy{};
         }
-    };
+        return policy;
+    }
 
     /**
-     * exception thrown if given vectors do not have the same size
+     * @return the hash function
      */
-    class VectorsLength : public std::exception
+    const Hash &_hasher() const noexcept
     {
-        virtual const char *what() const noexcept
-        {
-            return "the vectors do not have same size";
-        }
-    };
+        return static_cast<const HashMapMember<Hash, 0> &>(*this).get();
+    }
 
+    /**
+     * @return the key comparison
+     */
+    const KeyEqual &_keyEqual() const noexcept
+    {
+        return static_cast<const HashMapMember<KeyEqual, 1> &>(*this).get();
+    }
 
-public:
     /**
-     * default constructor of HashMap
+     * @return the allocator
      */
-    HashMap() : _capacity(DEFAULT_CAPACITY), _size(0)
+    const Allocator &_allocator() const noexcept
     {
-        _hashTable = new bucket<KeyT, ValueT>[DEFAULT_CAPACITY];
+        return static_cast<const HashMapMember<Allocator, 2> &>(*this).get();
     }
 
     /**
-     * a constructor that gets an iterator for keys and iterator for values and constructs a
-     * HashMap with matching pairs
-     * @tparam KeysInputIterator - type of keys iterator
-     * @tparam ValuesInputIterator - type of values iterator
-     * @param keysBegin - beginning of keys iterator
-     * @param keysEnd - end of keys iterator
-     * @param valuesBegin - beginning of values iterator
-     * @param valuesEnd - end of values iterator
+     * @param holder - a holder of the map
+     * @return the held object
      */
-    template<typename KeysInputIterator, typename ValuesInputIterator>
-    HashMap(const KeysInputIterator keysBegin, const KeysInputIterator keysEnd,
-            const ValuesInputIterator valuesBegin, const ValuesInputIterator valuesEnd) : HashMap()
+    template<typename T, int Tag>
+    static T &_member(HashMapMember<T, Tag> &holder) noexcept
     {
-        auto it1 = keysBegin;
-        auto it2 = valuesBegin;
-        if (std::distance(keysBegin, keysEnd) - std::distance(valuesBegin, valuesEnd))
-        {
-            throw VectorsLength{};
-        }
-        while (it1 != keysEnd)
+        return holder.get();
+    }
+
+    /**
+     * takes the allocator of another map on copy assignment, if the allocator asks for it. the
+     * tables allocated by the current allocator are freed first
+     * @param other - the map being copied
+     */
+    void _copyAllocator(const HashMap &other, std::true_type) noexcept
+    {
+        if (_allocator() != other._allocator())
         {
-            KeyT curKey = *it1;
-            ValueT curVal = *it2;
-            if (!insert(curKey, curVal)) // the HashMap already contains this key, we need to
-                // override its value
-            {
-                at(curKey) = curVal;
-            }
-            it1++;
-            it2++;
+            _deleteTable(_oldTable, _oldCapacity);
+            _deleteTable(_hashTable, _capacity);
+            _resetToEmptyTable();
+            _member<Allocator, 2>(*this) = other._allocator();
+            _resetEmptyBucket();
+            // copying an empty bitmap passes the allocator on, without allocating
+            OccupancyBits empty(_wordAllocator());
+            _occupied = empty;
+            _oldOccupied = empty;
         }
     }
 
     /**
-     * copy constructor
-     * @param other - HashMap to copy from
+     * keeps the allocator on copy assignment
+     */
+    void _copyAllocator(const HashMap &, std::false_type) noexcept
+    {}
+
+    /**
+     * swaps the allocators of two maps, if the allocator asks for it
+     * @param other - the other map
      */
-    HashMap(const HashMap &other) : HashMap()
+    void _swapAllocator(HashMap &other, std::true_type) noexcept
     {
-        *this = other;
+        using std::swap;
+        swap(_member<Allocator, 2>(*this), _member<Allocator, 2>(other));
+        _resetEmptyBucket();
+        other._resetEmptyBucket();
     }
 
     /**
-     * HashMap destructor
+     * keeps the allocators on swap, they must be equal
      */
-    ~HashMap()
+    void _swapAllocator(HashMap &, std::false_type) noexcept
+    {}
+
+    /**
+     * swaps the bitmaps of two maps, along with their allocators. a vector only swaps its
+     * allocator if the allocator propagates on swap
+     * @param other - the other map
+     */
+    void _swapOccupied(HashMap &other, std::false_type) noexcept
     {
-        delete[] _hashTable;
+        _occupied.swap(other._occupied);
+        _oldOccupied.swap(other._oldOccupied);
     }
 
     /**
-     * @return size of the hashMap
+     * swaps the bitmaps of two maps by moves, for an allocator that moves on move assignment but
+     * not on swap, so each bitmap keeps the allocator it came from
+     * @param other - the other map
      */
-    size_t size() const noexcept
+    void _swapOccupied(HashMap &other, std::true_type) noexcept
     {
-        return _size;
+        OccupancyBits occupied(std::move(_occupied));
+        _occupied = std::move(other._occupied);
+        other._occupied = std::move(occupied);
+        OccupancyBits oldOccupied(std::move(_oldOccupied));
+        _oldOccupied = std::move(other._oldOccupied);
+        other._oldOccupied = std::move(oldOccupied);
     }
 
     /**
-     * @return current capacity of the hashMap
+     * @return the allocator of the list nodes
      */
-    size_t capacity() const noexcept
+    NodeAllocator _nodeAllocator() const noexcept
     {
-        return _capacity;
+        return NodeAllocator(_allocator());
     }
 
     /**
-     * @return true if hashMap is empty
+     * @return the allocator of the occupancy bitmaps
      */
-    bool empty() const noexcept
+    WordAllocator _wordAllocator() const noexcept
     {
-        return _size == 0;
+        return WordAllocator(_allocator());
     }
 
     /**
-     * the function gets a key and a value, and inserts them to the hashMap
-     * @param key - the key
-     * @param val - the value
-     * @return - true if the insertion ended successfully
+     * allocates a table of empty buckets with the map's allocator
+     * @param buckets - number of buckets
+     * @return the table
      */
-    bool insert(const KeyT &key, const ValueT &val) noexcept
+    Bucket *_newTable(size_t buckets) noexcept(false)
     {
-        if (contains_key(key))
+        BucketAllocator allocator(_allocator());
+        Bucket *table = std::allocator_traits<BucketAllocator>::allocate(allocator, buckets);
+        size_t i = 0;
+        try
         {
-            return false;
+            for (; i < buckets; i++)
+            {
+                ::new((void *) (table + i)) Bucket(_nodeAllocator());
+            }
         }
-        size_t index = _hash(key);
-        _hashTable[index].push_back(pair<KeyT, ValueT>{key, val});
-        _size++;
-        if (_upperLoadFactor())
+        catch (...)
         {
-            _rehash(capacity() * 2);
+            _deleteBuckets(table, i, buckets);
+            throw;
         }
-        return true;
+        return table;
     }
 
     /**
-     * the function checks if a certain key is already in the map
-     * @param key - the key we are looking for
-     * @return - true if it does
+     * destroys the first buckets of a table and frees it
+     * @param table - the table
+     * @param constructed - number of buckets that were constructed
+     * @param buckets - number of buckets the table was allocated with
      */
-    bool contains_key(const KeyT &key) const noexcept
+    void _deleteBuckets(Bucket *table, size_t constructed, size_t buckets) noexcept
     {
-        int index = _hash(key);
-        if (empty() || _hashTable[index].empty())
-        {
-            return false;
-        }
-        for (auto &tuple: _hashTable[index])
+        if (!_abandonsNodes())
         {
-            if (tuple.first == key)
+            for (size_t i = 0; i < constructed; i++)
             {
-                return true;
+                table[i].~Bucket();
             }
         }
-        return false;
+        BucketAllocator allocator(_allocator());
+        std::allocator_traits<BucketAllocator>::deallocate(allocator, table, buckets);
     }
 
     /**
-     * const version of the function - the function gets a key and returns its value. in case the
-     * key is not in the hashMap an exception is thrown.
-     * @param key - the key
-     * @return - key's value
+     * @return true if the nodes need not be freed one by one - their elements are trivially
+     * destructible and the allocator frees nothing until its memory is released at once. such
+     * buckets are dropped, or constructed anew, without being destroyed
      */
-    const ValueT &at(const KeyT &key) const noexcept(false)
+    bool _abandonsNodes() const noexcept
     {
-        size_t index = _hash(key);
-        for (auto &tuple: _hashTable[index])
-        {
-            if (tuple.first == key)
-            {
-                return tuple.second;
-            }
-        }
-        throw KeyNotFound{};
+        return std::is_trivially_destructible<pair<KeyT, ValueT>>::value &&
+               hashMapMonotonic(_allocator());
     }
 
     /**
-     * the function gets a key and returns its value. in case the key is not in the hashMap an
-     * exception is thrown
-     * @param key - the key
-     * @return - key's value
+     * frees a table allocated by _newTable, with its nodes. nothing is done for nullptr or the
+     * map's empty table
+     * @param table - the table
+     * @param buckets - its capacity
      */
-    ValueT &at(const KeyT &key) noexcept(false)
+    void _deleteTable(Bucket *table, size_t buckets) noexcept
     {
-        size_t index = _hash(key);
-        for (auto &tuple: _hashTable[index])
+        if (table != nullptr && table != _emptyTable())
         {
-            if (tuple.first == key)
-            {
-                return tuple.second;
-            }
+            _deleteBuckets(table, buckets, buckets);
         }
-        throw KeyNotFound{};
     }
 
     /**
-     * the function gets a key and erases its value
-     * @param key - the key
-     * @return - true if the erase was done successfully
+     * @return the map's empty table of a single bucket, held by moved from maps. lookups read it
+     * like any other table, and the first insertion replaces it with a table of its own
      */
-    bool erase(const KeyT &key) noexcept
+    Bucket *_emptyTable() noexcept
     {
-        if (!contains_key(key))
-        {
-            return false;
-        }
-        size_t index = _hash(key);
-        for (auto tuple: _hashTable[index])
-        {
-            if (tuple.first == key)
-            {
-                _hashTable[index].remove(tuple);
-                break;
-            }
-        }
-        _size--;
-        if (_lowerLoadFactor() && capacity() > MINIMAL_CAPACITY)
-        {
-            _rehash(capacity() / 2);
-        }
-        return true;
+        return &_emptyBucket;
     }
 
     /**
-     * @return current load factor
+     * @return the map's empty table
      */
-    double load_factor() const noexcept
+    const Bucket *_emptyTable() const noexcept
     {
-        return (double) size() / capacity();
+        return &_emptyBucket;
     }
 
     /**
-     * the function gets a key and returns it's bucket size. the function throws an exception if
-     * the key was not found
-     * @param key - the key
-     * @return - size of bucket
+     * reconstructs the empty bucket with the map's allocator, after the allocator was replaced
      */
-    size_t bucket_size(const KeyT &key) const noexcept(false)
+    void _resetEmptyBucket() noexcept
     {
-        if (!contains_key(key))
-        {
-            throw KeyNotFound{};
-        }
-        size_t index = _hash(key);
-        return _hashTable[index].size();
+        _emptyBucket.~Bucket();
+        ::new((void *) &_emptyBucket) Bucket(_nodeAllocator());
     }
 
     /**
-     * the function gets a key and returns the bucket's index if the map contains the key, or
-     * throws an exception if not
-     * @param key - the key
-     * @return - bucket index
+     * @param buckets - number of buckets
+     * @return number of bitmap words that cover the buckets
      */
-    size_t bucket_index(const KeyT &key) const noexcept(false)
+    static size_t _occupancyWords(size_t buckets) noexcept
+    {
+        return (buckets + OCCUPANCY_WORD_BITS - 1) / OCCUPANCY_WORD_BITS;
+    }
+
+    /**
+     * sets or clears the bit of a bucket
+     * @param bits - the bitmap of the bucket's table
+     * @param idx - index of the bucket in its table
+     * @param occupied - true if the bucket is not empty
+     */
+    static void _setOccupied(OccupancyBits &bits, size_t idx, bool occupied) noexcept
     {
-        if (!contains_key(key))
+        uint64_t mask = (uint64_t) 1 << (idx % OCCUPANCY_WORD_BITS);
+        if (occupied)
         {
-            throw KeyNotFound{};
+            bits[idx / OCCUPANCY_WORD_BITS] |= mask;
+        }
+        else
+        {
+            bits[idx / OCCUPANCY_WORD_BITS] &= ~mask;
         }
-        return _hash(key);
     }
 
     /**
-     * the function clears the map from all elements
+     * updates the bit of a bucket after nodes were linked into it or unlinked from it
+     * @param idx - index in [0, _bucketCount()), the old table buckets come first
      */
-    void clear() noexcept
+    void _updateOccupied(size_t idx) noexcept
     {
-        for (size_t i = 0; i < _capacity; i++)
+        if (idx < _oldCapacity)
         {
-            _hashTable[i].clear();
+            _setOccupied(_oldOccupied, idx, !_oldTable[idx].empty());
+        }
+        else
+        {
+            _setOccupied(_occupied, idx - _oldCapacity, !_hashTable[idx - _oldCapacity].empty());
         }
-        _size = 0;
     }
 
     /**
-     * assignment operator
-     * @param other - hashMap to copy elements from
-     * @return reference to HashMap
+     * recomputes some words of the table's bitmap from its buckets. each word covers buckets of
+     * its own, so disjoint ranges of words may be recomputed in parallel
+     * @param first - first word
+     * @param last - one past the last word
      */
-    HashMap &operator=(const HashMap &other) noexcept
+    void _refreshOccupied(size_t first, size_t last) noexcept
     {
-        if (this != &other)
+        for (size_t word = first; word < last; word++)
         {
-            this->clear();
-            delete[] this->_hashTable;
-            this->_capacity = other.capacity();
-            this->_size = other.size();
-            this->_hashTable = new bucket<KeyT, ValueT>[_capacity];
-            for (size_t i = 0; i < other.capacity(); i++)
+            uint64_t bits = 0;
+            size_t end = (word + 1) * OCCUPANCY_WORD_BITS < _capacity ?
+                         (word + 1) * OCCUPANCY_WORD_BITS : _capacity;
+            for (size_t i = word * OCCUPANCY_WORD_BITS; i < end; i++)
             {
-                _hashTable[i] = other._hashTable[i];
+                if (!_hashTable[i].empty())
+                {
+                    bits |= (uint64_t) 1 << (i % OCCUPANCY_WORD_BITS);
+                }
             }
+            _occupied[word] = bits;
         }
-        return *this;
     }
 
     /**
-     * subscript operator
-     * @param key
-     * @return
+     * recomputes the table's bitmap on the threads of an executor
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
      */
-    ValueT &operator[](const KeyT &key) noexcept
+    template<typename Executor>
+    void _parallelRefreshOccupied(Executor &executor) noexcept(false)
     {
-        int index = _hash(key);
-        if (empty() || _hashTable[index].empty() || !contains_key(key))
-        {
-            insert(key, ValueT());
-        }
-        for (auto &tuple: _hashTable[index])
+        executor.parallel_for(0, _occupied.size(), [this](size_t first, size_t last)
+                              {
+                                  _refreshOccupied(first, last);
+                              }, PARALLEL_BUCKET_GRAIN / OCCUPANCY_WORD_BITS);
+    }
+
+    /**
+     * recomputes both bitmaps from the buckets, after changes that touched many buckets
+     */
+    void _rebuildOccupied() noexcept(false)
+    {
+        _occupied.assign(_occupancyWords(_capacity), 0);
+        _refreshOccupied(0, _occupied.size());
+        _oldOccupied.assign(_occupancyWords(_oldCapacity), 0);
+        for (size_t i = _migrated; i < _oldCapacity; i++)
         {
-            if (tuple.first == key)
-            {
-                return tuple.second;
-            }
+            _setOccupied(_oldOccupied, i, !_oldTable[i].empty());
         }
-        return at(key);
     }
 
     /**
-     * subscript operator
-     * @param key
-     * @return
+     * @param bits - the bitmap of a table
+     * @param from - index of the first bucket to look at
+     * @param limit - one past the last bucket to look at, at most the capacity of the table. no
+     * word past the one of the last bucket is read
+     * @return index of the first non empty bucket in [from, limit), limit if there is none
      */
-    ValueT operator[](const KeyT &key) const noexcept
+    static size_t _scanOccupied(const OccupancyBits &bits, size_t from,
+                                size_t limit) noexcept
     {
-        int index = _hash(key);
-        if (empty() || _hashTable[index].empty() || !contains_key(key))
+        size_t words = _occupancyWords(limit) < bits.size() ? _occupancyWords(limit) : bits.size();
+        size_t word = from / OCCUPANCY_WORD_BITS;
+        if (from >= limit || word >= words)
         {
-            return ValueT();
+            return limit;
         }
-        for (auto &tuple: _hashTable[index])
+        uint64_t current = bits[word] & (~(uint64_t) 0 << (from % OCCUPANCY_WORD_BITS));
+        while (current == 0)
         {
-            if (tuple.first == key)
+            if (++word == words)
             {
-                return tuple.second;
+                return limit;
             }
+            current = bits[word];
         }
-        return at(key);
+        size_t found = word * OCCUPANCY_WORD_BITS + hashMapLowestBit(current);
+        return found < limit ? found : limit;
     }
 
     /**
-     * checks if two hashMaps are identical
-     * @param other - another hashMap
-     * @return true if they are
+     * @param idx - index in [0, _bucketCount()], the old table buckets come first
+     * @return index of the first non empty bucket from the given one on, _bucketCount() if there
+     * is none
      */
-    bool operator==(const HashMap &other) const noexcept
+    size_t _nextOccupied(size_t idx) const noexcept
     {
-        if (this->capacity() != other.capacity() || this->size() != other.size())
-        {
-            return false;
-        }
-        for (size_t i = 0; i < this->capacity(); i++)
+        if (idx < _oldCapacity)
         {
-            for (const auto &tuple: _hashTable[i])
+            size_t found = _scanOccupied(_oldOccupied, idx, _oldCapacity);
+            if (found < _oldCapacity)
             {
-                if (!other.contains_key(tuple.first) || other[tuple.first] != tuple.second)
-                {
-                    return false;
-                }
+                return found;
             }
+            idx = _oldCapacity;
         }
-        return true;
+        return _oldCapacity + _scanOccupied(_occupied, idx - _oldCapacity, _capacity);
     }
 
     /**
-     * checks if two hashMaps are not identical
-     * @param other - another hashMap
-     * @return true if they are different
+     * gives the map a table of its own if it holds its empty table
      */
-    bool operator!=(const HashMap &other) const noexcept
+    void _ensureTable() noexcept(false)
     {
-        return !(*this == other);
+        if (_hashTable == _emptyTable())
+        {
+            _occupied.assign(_occupancyWords(DEFAULT_CAPACITY), 0);
+            _hashTable = _newTable(DEFAULT_CAPACITY);
+            _capacity = DEFAULT_CAPACITY;
+        }
     }
 
+    /**
+     * leaves the map empty, holding its empty table. the tables are not freed, their
+     * ownership must have been passed on
+     */
+    void _resetToEmptyTable() noexcept
+    {
+        _hashTable = _emptyTable();
+        _capacity = MINIMAL_CAPACITY;
+        _size = 0;
+        _oldTable = nullptr;
+        _oldCapacity = 0;
+        _migrated = 0;
+        _minCapacity = 0;
+        _lowLoadErases = 0;
+        _occupied.clear();
+        _oldOccupied.clear();
+        _reseedFloor = 0;
+    }
 
-// -------------------------- iterator class -------------------------
+    /**
+     * drops an incremental rehash in progress and makes sure the table has a given capacity. the
+     * table is only replaced if its capacity differs (its nodes are left for reuse otherwise), so
+     * it must be cleared or overwritten by the caller
+     * @param newCapacity - the capacity of the table
+     */
+    void _resetTable(size_t newCapacity) noexcept(false)
+    {
+        if (this->capacity() != newCapacity || this->_hashTable == _emptyTable())
+        {
+            this->_occupied.assign(_occupancyWords(newCapacity), 0);
+            auto *newTable = _newTable(newCapacity);
+            _deleteTable(this->_hashTable, this->_capacity);
+            this->_hashTable = newTable;
+            this->_capacity = newCapacity;
+        }
+        _deleteTable(this->_oldTable, this->_oldCapacity);
+        this->_oldTable = nullptr;
+        this->_oldCapacity = 0;
+        this->_migrated = 0;
+        this->_oldOccupied.clear();
+    }
 
     /**
-     * class of a const iterator for HashMap
+     * grows the table to a given capacity, without pinning it like reserve does
+     * @param newCapacity - the wanted capacity
      */
-    class ConstIterator
+    void _growTo(size_t newCapacity) noexcept(false)
     {
-        const HashMap *_map;
-        size_t _curIndex;
-        typename list<pair<KeyT, ValueT>>::const_iterator _cur;
-        int _counter;
+        if (newCapacity > capacity())
+        {
+            _rehash(newCapacity);
+        }
+    }
 
-    public:
-        /**
-         * iterator traits:
-         */
-        typedef pair<KeyT, ValueT> value_type;
-        typedef const pair<KeyT, ValueT> *pointer;
-        typedef const pair<KeyT, ValueT> &reference;
-        typedef int difference_type;
-        typedef std::forward_iterator_tag iterator_category;
+    /**
+     * makes room for the pairs of a range that can be measured before it is read
+     * @param first - beginning of the range
+     * @param last - end of the range
+     */
+    template<typename ForwardIterator>
+    void _reserveRange(ForwardIterator first, ForwardIterator last,
+                       std::forward_iterator_tag) noexcept(false)
+    {
+        _growTo(_fitCapacity(size() + (size_t) std::distance(first, last)));
+    }
 
+    /**
+     * a single pass range can not be measured, its pairs are inserted with the usual growth
+     */
+    template<typename InputIterator>
+    void _reserveRange(InputIterator, InputIterator, std::input_iterator_tag) noexcept
+    {}
 
-        /**
-         * @return the data of the element pointed to by the iterator
-         */
-        value_type operator*() const
+    /**
+     * inserts all elements of another map into this map, which must be empty. the other map's
+     * keys are unique, so each element is linked into its bucket without a lookup, and when both
+     * tables have the same capacity whole buckets are copied
+     * @param other - the map to copy elements from
+     */
+    void _insertAll(const HashMap &other) noexcept(false)
+    {
+        size_t newCapacity = _fitCapacity(other.size());
+        _resetTable(newCapacity > capacity() ? newCapacity : capacity());
+        if (capacity() == other.capacity() && _sameHash(other))
         {
-            return *_cur;
+            _copyBuckets(other);
+            return;
         }
-
-        /**
-         * assignment operator for iterator - points to the same HashMap object, same bucket
-         * index and same pair of KeyT, ValueT
-         * @param other
-         * @return
-         */
-        ConstIterator &operator=(const ConstIterator &other)
+        for (size_t i = other._nextOccupied(0); i < other._bucketCount();
+             i = other._nextOccupied(i + 1))
         {
-            if (this != &other)
+            for (const auto &tuple: other._bucketAt(i))
             {
-                this->_map = other._map;
-                this->_curIndex = other._curIndex;
-                this->_cur = other._cur;
-                this->_counter = other._counter;
+                size_t idx = _hash(tuple.first);
+                _hashTable[idx].push_back(tuple);
+                _setOccupied(_occupied, idx, true);
             }
-            return *this;
         }
+        _size = other._size;
+    }
 
-        /**
-         * prefix increment operator
-         * @return
-         */
-        ConstIterator &operator++()
+    /**
+     * moves all nodes of a bucket to their buckets in another table. the list nodes are relinked,
+     * so no node is allocated and no key or value is copied
+     * @param from - the bucket to empty
+     * @param table - the destination table
+     * @param tableCapacity - capacity of the destination table
+     * @param occupied - bitmap of the destination table, nullptr if the caller rebuilds it
+     */
+    void _relinkBucket(Bucket &from, Bucket *table,
+                       size_t tableCapacity, OccupancyBits *occupied) const noexcept
+    {
+        while (!from.empty())
         {
-            _cur++;
-            _counter++;
-            while (_cur == _map->_hashTable[_curIndex].end() && ++_curIndex < _map->capacity())
+            size_t idx = _hashCode(from.front().first) & (tableCapacity - 1);
+            table[idx].splice(table[idx].end(), from, from.begin());
+            if (occupied != nullptr)
             {
-                _cur = _map->_hashTable[_curIndex].begin();
+                _setOccupied(*occupied, idx, true);
             }
-            return *this;
         }
+    }
 
-        /**
-         * postfix increment operator
-         * @return
-         */
-        ConstIterator operator++(int)
+    /**
+     * copies the elements of another map into this one, whose table must have the capacity of
+     * the other table. a bucket is assigned as a whole, which reuses the nodes that are already
+     * in it, and the elements of another map in the middle of an incremental rehash are copied
+     * straight to their final bucket
+     * @param other - the map to copy elements from
+     */
+    void _copyBuckets(const HashMap &other) noexcept(false)
+    {
+        for (size_t i = 0; i < _capacity; i++)
         {
-            ConstIterator tmp(*this);
-            ++(*this);
-            return tmp;
+            _hashTable[i] = other._hashTable[i];
         }
-
-        /**
-         * equal operator
-         * @param other - other iterator
-         * @return true if iterators are the same
-         */
-        bool operator==(const ConstIterator &other) const
+        for (size_t i = other._migrated; i < other._oldCapacity; i++)
         {
-            return this->_map == other._map && this->_counter == other._counter;
+            for (const auto &tuple: other._oldTable[i])
+            {
+                _hashTable[_hash(tuple.first)].push_back(tuple);
+            }
         }
+        _size = other._size;
+        _rebuildOccupied();
+    }
 
-        /**
-         * not equal operator
-         * @param other - other iterator
-         * @return true if iterators are not the same
-         */
-        bool operator!=(const ConstIterator &other) const
+    /**
+     * creates a new hashTable and transfers all items from the old one, also deletes the old
+     * hashTable. in incremental mode the items are only moved over the following operations
+     * @param newCapacity - the capacity after resizing
+     */
+    void _rehash(size_t newCapacity) noexcept(false)
+    {
+        _finishMigration();
+        OccupancyBits newOccupied(_occupancyWords(newCapacity), 0, _wordAllocator());
+        if (_hashTable == _emptyTable())
         {
-            return !(*this == other);
+            _hashTable = _newTable(newCapacity);
+            _capacity = newCapacity;
+            _occupied.swap(newOccupied);
+            return;
         }
-
-        /**
-         * @return pointer to the element pointed to by the iterator
-         */
-        pointer operator->() const
+        if (_rehashStep)
         {
-            return &(*_cur);
+            auto *newMap = _newTable(newCapacity);
+            _oldTable = _hashTable;
+            _oldCapacity = _capacity;
+            _hashTable = newMap;
+            _capacity = newCapacity;
+            _oldOccupied.swap(_occupied);
+            _occupied.swap(newOccupied);
+            _migrateStep();
+            return;
         }
-
-        ConstIterator() : _map(nullptr), _curIndex(0),
-                          _cur(nullptr), _counter(0)
-        {}
-
-        /**
-         * const iterator constructor
-         * @param node
-         */
-        ConstIterator(const HashMap *hashMap, bool end) : _map(hashMap),
-                                                          _curIndex(0),
-                                                          _cur(nullptr), _counter(0)
+        auto *newMap = _newTable(newCapacity);
+        for (size_t i = _nextOccupied(0); i < capacity(); i = _nextOccupied(i + 1))
         {
-            if (end)
-            {
-                _curIndex = _map->capacity();
-                _counter = _map->size();
-            }
-            else
-            {
-                _curIndex = 0;
-                if (!_map->_hashTable[_curIndex].empty())
-                {
-                    _cur = _map->_hashTable[_curIndex].begin();
-                }
-                while (_map->_hashTable[_curIndex].empty() && ++_curIndex < _map->capacity())
-                {
-                    _cur = _map->_hashTable[_curIndex].begin();
-                }
-            }
+            _relinkBucket(_hashTable[i], newMap, newCapacity, &newOccupied);
         }
+        _deleteTable(_hashTable, _capacity);
+        _hashTable = newMap;
+        _capacity = newCapacity;
+        _occupied.swap(newOccupied);
+    }
 
-        /**
-         * const iterator copy constructor
-         * @param other
-         */
-        ConstIterator(const ConstIterator &other) : _map(other._map), _curIndex(other._curIndex),
-                                                    _cur(other._cur), _counter(other._counter)
-        {}
-    };
+    /**
+     * moves the next _rehashStep buckets of an incremental rehash to the new table, and deletes
+     * the old table once all of its buckets were moved
+     */
+    void _migrateStep() noexcept(false)
+    {
+        if (_oldTable == nullptr)
+        {
+            return;
+        }
+        size_t last = _migrated + _rehashStep < _oldCapacity ? _migrated + _rehashStep
+                                                              : _oldCapacity;
+        for (; _migrated < last; _migrated++)
+        {
+            _relinkBucket(_oldTable[_migrated], _hashTable, _capacity, &_occupied);
+            _setOccupied(_oldOccupied, _migrated, false);
+        }
+        if (_migrated == _oldCapacity)
+        {
+            _deleteTable(_oldTable, _oldCapacity);
+            _oldTable = nullptr;
+            _oldCapacity = 0;
+            _migrated = 0;
+            _oldOccupied.clear();
+        }
+    }
 
-    typedef ConstIterator const_iterator;
-    typedef ConstIterator iterator;
+    /**
+     * moves all buckets that are left in an incremental rehash
+     */
+    void _finishMigration() noexcept(false)
+    {
+        if (_oldTable != nullptr)
+        {
+            size_t step = _rehashStep;
+            _rehashStep = _oldCapacity;
+            _migrateStep();
+            _rehashStep = step;
+        }
+    }
 
-    const_iterator begin() const
+    /**
+     * @param key - the key we want to add
+     * @return an index according to the wanted hash function
+     */
+    size_t _hash(const KeyT &key) const noexcept
     {
-        return ConstIterator(this, false);
+        return _hashCode(key) & (capacity() - 1);
     }
 
-    const_iterator end() const
+    /**
+     * @param key - a key
+     * @return the full hash of the key after the policy's finalizer, a bucket index is taken from
+     * its low bits
+     */
+    size_t _hashCode(const KeyT &key) const noexcept
     {
-        return ConstIterator(this, true);
+        return _hashCodeOf(key);
     }
 
-    const_iterator cbegin() const
+    /**
+     * @param key - a key, or a value of another type a transparent Hash takes
+     * @return the full hash of the key after the policy's finalizer
+     */
+    template<typename K>
+    size_t _hashCodeOf(const K &key) const noexcept
     {
-        return begin();
+        if (_policy.finalizer == HashMapFinalizer::SIPHASH)
+        {
+            return _sipHashCode(key, std::integral_constant<bool, std::is_same<K, KeyT>::value &&
+                                     std::is_same<Hash, std::hash<KeyT>>::value>{});
+        }
+        size_t code = _hasher()(key);
+        switch (_policy.finalizer)
+        {
+            case HashMapFinalizer::FIBONACCI:
+                return fibonacciHash(code);
+            case HashMapFinalizer::MURMUR:
+                return mixHash(code);
+            default:
+                return code;
+        }
     }
 
-    const_iterator cend() const
+    /**
+     * @param key - a key
+     * @return sipHashOf the key itself, for the standard hash function
+     */
+    size_t _sipHashCode(const KeyT &key, std::true_type) const noexcept
     {
-        return end();
+        return (size_t) sipHashOf(key, _seed);
     }
-};
 
+    /**
+     * @param key - a key, or a value of another type a transparent Hash takes
+     * @return sipHash of the Hash of the key, whose equal keys may have different bytes
+     */
+    template<typename K>
+    size_t _sipHashCode(const K &key, std::false_type) const noexcept
+    {
+        size_t code = _hasher()(key);
+        return (size_t) sipHash(&code, sizeof(code), _seed);
+    }
+
+    /**
+     * relinks every node to the bucket picked by the current hash function, in one go. no
+     * incremental rehash may be in progress
+     */
+    void _rehashAll() noexcept(false)
+    {
+        if (_hashTable == _emptyTable())
+        {
+            return;
+        }
+        size_t step = _rehashStep;
+        _rehashStep = 0;
+        try
+        {
+            _rehash(capacity());
+        }
+        catch (...)
+        {
+            _rehashStep = step;
+            throw;
+        }
+        _rehashStep = step;
+    }
+
+    /**
+     * draws a new key for the SIPHASH finalizer and relinks all elements with it
+     */
+    void _reseed() noexcept(false)
+    {
+        SipKey seed = randomSipKey();
+        _finishMigration();
+        SipKey previous = _seed;
+        _seed = seed;
+        try
+        {
+            _rehashAll();
+        }
+        catch (...)
+        {
+            _seed = previous;
+            throw;
+        }
+        _reseedFloor = 2 * _size;
+    }
+
+    /**
+     * @param other - another map
+     * @return true if both maps put every key in the same bucket of a table of a given capacity.
+     * a Hash with a state is not compared, so it is never known to be the same
+     */
+    bool _sameHash(const HashMap &other) const noexcept
+    {
+        return std::is_empty<Hash>::value && _policy.finalizer == other._policy.finalizer &&
+               (_policy.finalizer != HashMapFinalizer::SIPHASH ||
+                (_seed.k0 == other._seed.k0 && _seed.k1 == other._seed.k1));
+    }
+
+    /**
+     * @param code - full hash of a key
+     * @return index in [0, _bucketCount()) of the bucket that holds the key, or would hold it once
+     * inserted - a bucket of the old table if it was not moved yet by an incremental rehash,
+     * otherwise of the new table
+     */
+    size_t _locate(size_t code) const noexcept
+    {
+        if (_oldTable != nullptr && (code & (_oldCapacity - 1)) >= _migrated)
+        {
+            return code & (_oldCapacity - 1);
+        }
+        return _oldCapacity + (code & (capacity() - 1));
+    }
+
+    /**
+     * @return number of buckets in the old and new tables together
+     */
+    size_t _bucketCount() const noexcept
+    {
+        return _oldCapacity + _capacity;
+    }
+
+    /**
+     * @param idx - index in [0, _bucketCount()), the old table buckets come first
+     * @return the bucket at the index
+     */
+    Bucket &_bucketAt(size_t idx) noexcept
+    {
+        return idx < _oldCapacity ? _oldTable[idx] : _hashTable[idx - _oldCapacity];
+    }
+
+    /**
+     * @param idx - index in [0, _bucketCount()), the old table buckets come first
+     * @return the bucket at the index
+     */
+    const Bucket &_bucketAt(size_t idx) const noexcept
+    {
+        return idx < _oldCapacity ? _oldTable[idx] : _hashTable[idx - _oldCapacity];
+    }
+
+    /**
+     * @param keyBucket - a bucket
+     * @param key - the key we are looking for
+     * @return the node of the key in the bucket, or the end of the bucket
+     */
+    NodeIterator _findIn(Bucket &keyBucket, const KeyT &key) const noexcept
+    {
+        return _findKeyIn(keyBucket, key);
+    }
+
+    /**
+     * @param keyBucket - a bucket
+     * @param key - the key we are looking for
+     * @return the node of the key in the bucket, or the end of the bucket
+     */
+    ConstNodeIterator _findIn(const Bucket &keyBucket, const KeyT &key) const noexcept
+    {
+        return _findKeyIn(keyBucket, key);
+    }
+
+    /**
+     * @param keyBucket - a bucket, const or not
+     * @param key - the key we are looking for, or a value of another type a transparent KeyEqual
+     * takes
+     * @return the node of the key in the bucket, or the end of the bucket
+     */
+    template<typename BucketT, typename K>
+    auto _findKeyIn(BucketT &keyBucket, const K &key) const noexcept -> decltype(keyBucket.begin())
+    {
+        auto it = keyBucket.begin();
+        while (it != keyBucket.end() && !_keyEqual()(it->first, key))
+        {
+            it++;
+        }
+        return it;
+    }
+
+    /**
+     * @param key - the key we are looking for, or a value of another type a transparent Hash and
+     * KeyEqual take
+     * @return the node of the key, or nullptr if it is not in the map
+     */
+    template<typename K>
+    const pair<KeyT, ValueT> *_findNode(const K &key) const noexcept
+    {
+        const Bucket &keyBucket = _bucketAt(_locate(_hashCodeOf(key)));
+        auto it = _findKeyIn(keyBucket, key);
+        return it == keyBucket.end() ? nullptr : &*it;
+    }
+
+    /**
+     * erases a key, and shrinks the table or moves a bucket of an incremental rehash
+     * @param key - the key, or a value of another type a transparent Hash and KeyEqual take
+     * @return true if the key was in the map
+     */
+    template<typename K>
+    bool _eraseKey(const K &key) noexcept
+    {
+        size_t idx = _locate(_hashCodeOf(key));
+        Bucket &keyBucket = _bucketAt(idx);
+        auto it = _findKeyIn(keyBucket, key);
+        if (it == keyBucket.end())
+        {
+            return false;
+        }
+        keyBucket.erase(it);
+        _updateOccupied(idx);
+        _size--;
+        _lowLoadErases = _lowerLoadFactor() ? _lowLoadErases + 1 : 0;
+        if (_lowLoadErases >= _policy.shrinkHysteresis && capacity() > _shrinkFloor())
+        {
+            _lowLoadErases = 0;
+            size_t newCapacity = capacity() / _policy.growthFactor;
+            _rehash(newCapacity > _shrinkFloor() ? newCapacity : _shrinkFloor());
+        }
+        else
+        {
+            _migrateStep();
+        }
+        return true;
+    }
+
+    /**
+     * looks up a batch of keys with group prefetching: the keys of a group are hashed and their
+     * buckets prefetched first, then the first node of every bucket is prefetched, and only then
+     * are the buckets searched, so the memory latency of the whole group overlaps
+     * @param first - beginning of the keys, a forward iterator over KeyT lvalues
+     * @param last - end of the keys
+     * @param resolve - called in order for every key with its bucket index and the node of the
+     * key in the bucket, or the end of the bucket
+     */
+    template<typename KeyIterator, typename Resolve>
+    void _lookupMany(KeyIterator first, KeyIterator last, Resolve resolve) const noexcept(false)
+    {
+        const KeyT *keys[PREFETCH_GROUP_SIZE];
+        size_t indices[PREFETCH_GROUP_SIZE];
+        while (first != last)
+        {
+            size_t count = 0;
+            for (; count < PREFETCH_GROUP_SIZE && first != last; ++first, ++count)
+            {
+                keys[count] = &*first;
+                indices[count] = _locate(_hashCode(*first));
+                HASHMAP_PREFETCH(&_bucketAt(indices[count]));
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const Bucket &keyBucket = _bucketAt(indices[i]);
+                if (!keyBucket.empty())
+                {
+                    HASHMAP_PREFETCH(&keyBucket.front());
+                }
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const Bucket &keyBucket = _bucketAt(indices[i]);
+                resolve(indices[i], keyBucket, _findIn(keyBucket, *keys[i]));
+            }
+        }
+    }
+
+    /**
+     * accounts for a node that was just linked into the map, and grows the table or moves
+     * buckets of an incremental rehash. the node itself never moves, only its bucket may change
+     * @param idx - index of the node's bucket, the old table buckets come first
+     */
+    void _afterInsert(size_t idx) noexcept(false)
+    {
+        _updateOccupied(idx);
+        _size++;
+        _lowLoadErases = 0;
+        if (_policy.finalizer == HashMapFinalizer::SIPHASH &&
+            _bucketAt(idx).size() > _policy.maxChainLength && _size > _reseedFloor)
+        {
+            _reseed();
+        }
+        if (_upperLoadFactor())
+        {
+            _rehash(capacity() * _policy.growthFactor);
+        }
+        else
+        {
+            _migrateStep();
+        }
+    }
+
+    /**
+     * @param node - a node of the map
+     * @param code - full hash of the node's key when it was looked up
+     * @return index of the node's bucket. an insert may have drawn a new SIPHASH key since the
+     * lookup, which moved the node to another bucket
+     */
+    size_t _indexOf(NodeIterator node, size_t code) const noexcept
+    {
+        if (_policy.finalizer == HashMapFinalizer::SIPHASH)
+        {
+            code = _hashCode(node->first);
+        }
+        return _locate(code);
+    }
+
+    /**
+     * single probe insertion - looks the key up once, and constructs its value from args only if
+     * it is not in the map
+     * @param code - full hash of the key
+     * @param key - the key
+     * @param args - arguments for the value constructor
+     * @return the node of the key, and true if it was inserted
+     */
+    template<typename K, typename... Args>
+    pair<NodeIterator, bool> _tryEmplace(size_t code, K &&key, Args &&... args) noexcept(false)
+    {
+        _ensureTable();
+        size_t idx = _locate(code);
+        Bucket &keyBucket = _bucketAt(idx);
+        auto it = _findIn(keyBucket, key);
+        if (it != keyBucket.end())
+        {
+            return {it, false};
+        }
+        keyBucket.emplace_back(std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        it = std::prev(keyBucket.end());
+        _afterInsert(idx);
+        return {it, true};
+    }
+
+    /**
+     * single probe insert or assign
+     * @param code - full hash of the key
+     * @param key - the key
+     * @param obj - the value to insert or assign
+     * @return the node of the key, and true if it was inserted
+     */
+    template<typename K, typename M>
+    pair<NodeIterator, bool> _insertOrAssign(size_t code, K &&key, M &&obj) noexcept(false)
+    {
+        _ensureTable();
+        size_t idx = _locate(code);
+        Bucket &keyBucket = _bucketAt(idx);
+        auto it = _findIn(keyBucket, key);
+        if (it != keyBucket.end())
+        {
+            it->second = std::forward<M>(obj);
+            return {it, false};
+        }
+        keyBucket.emplace_back(std::forward<K>(key), std::forward<M>(obj));
+        it = std::prev(keyBucket.end());
+        _afterInsert(idx);
+        return {it, true};
+    }
+
+    /**
+     * runs fn(0), ..., fn(count - 1) on the threads of an executor, one index per task
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
+     * @param count - number of indices
+     * @param fn - called with an index, possibly from several threads at once
+     */
+    template<typename Executor, typename Function>
+    static void _runParts(Executor &executor, size_t count, Function &fn) noexcept(false)
+    {
+        executor.parallel_for(0, count, [&fn](size_t first, size_t last)
+                              {
+                                  for (size_t i = first; i < last; i++)
+                                  {
+                                      fn(i);
+                                  }
+                              }, 1);
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the HashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+    /**
+     * exception thrown if given vectors do not have the same size
+     */
+    class VectorsLength : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "the vectors do not have same size";
+        }
+    };
+
+    /**
+     * exception thrown if a given resize policy can not be used
+     */
+    class InvalidPolicy : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "invalid resize policy";
+        }
+    };
+
+
+public:
+    /**
+     * default constructor of HashMap
+     */
+    HashMap() : HashMap(HashMapPolicy{})
+    {}
+
+    /**
+     * constructor of an empty HashMap whose tables and nodes come from a given allocator
+     * @param allocator - the allocator
+     */
+    explicit HashMap(const Allocator &allocator) : HashMap(HashMapPolicy{}, Hash(), KeyEqual(),
+                                                           allocator)
+    {}
+
+    /**
+     * constructor of an empty HashMap with a given resize policy
+     * @param policy - the resize policy
+     * @param hash - the hash function
+     * @param equal - the key comparison
+     * @param allocator - the allocator
+     */
+    explicit HashMap(const HashMapPolicy &policy, const Hash &hash = Hash(),
+                     const KeyEqual &equal = KeyEqual(), const Allocator &allocator = Allocator()) :
+            HashMapMember<Hash, 0>(hash), HashMapMember<KeyEqual, 1>(equal),
+            HashMapMember<Allocator, 2>(allocator), _capacity(DEFAULT_CAPACITY), _size(0),
+            _emptyBucket(_nodeAllocator()), _oldTable(nullptr), _oldCapacity(0), _migrated(0),
+            _rehashStep(0), _policy(_checkPolicy(policy)), _minCapacity(0), _lowLoadErases(0),
+            _occupied(_occupancyWords(DEFAULT_CAPACITY), 0, WordAllocator(allocator)),
+            _oldOccupied(WordAllocator(allocator)), _seed(), _reseedFloor(0)
+    {
+        if (_policy.finalizer == HashMapFinalizer::SIPHASH)
+        {
+            _seed = randomSipKey();
+        }
+        _hashTable = _newTable(DEFAULT_CAPACITY);
+    }
+
+    /**
+     * a constructor that gets an iterator for keys and iterator for values and constructs a
+     * HashMap with matching pairs
+     * @tparam KeysInputIterator - type of keys iterator
+     * @tparam ValuesInputIterator - type of values iterator
+     * @param keysBegin - beginning of keys iterator
+     * @param keysEnd - end of keys iterator
+     * @param valuesBegin - beginning of values iterator
+     * @param valuesEnd - end of values iterator
+     * @param allocator - the allocator, needed for an allocator that is not default constructible
+     */
+    template<typename KeysInputIterator, typename ValuesInputIterator>
+    HashMap(const KeysInputIterator keysBegin, const KeysInputIterator keysEnd,
+            const ValuesInputIterator valuesBegin, const ValuesInputIterator valuesEnd,
+            const Allocator &allocator = Allocator()) : HashMap(allocator)
+    {
+        auto it1 = keysBegin;
+        auto it2 = valuesBegin;
+        auto pairs = std::distance(keysBegin, keysEnd);
+        if (pairs - std::distance(valuesBegin, valuesEnd))
+        {
+            throw VectorsLength{};
+        }
+        // size the table once, so the pairs are linked straight into their final buckets
+        _growTo(_fitCapacity((size_t) pairs));
+        while (it1 != keysEnd)
+        {
+            // the HashMap may already contain this key, we need to override its value
+            _insertOrAssign(_hashCode(*it1), *it1, *it2);
+            it1++;
+            it2++;
+        }
+    }
+
+    /**
+     * copy constructor
+     * @param other - HashMap to copy from
+     */
+    HashMap(const HashMap &other) :
+            HashMapMember<Hash, 0>(other._hasher()), HashMapMember<KeyEqual, 1>(other._keyEqual()),
+            HashMapMember<Allocator, 2>(
+                    AllocatorTraits::select_on_container_copy_construction(other._allocator())),
+            _capacity(other._capacity), _size(0), _emptyBucket(_nodeAllocator()),
+            _oldTable(nullptr), _oldCapacity(0), _migrated(0), _rehashStep(other._rehashStep),
+            _policy(other._policy), _minCapacity(other._minCapacity), _lowLoadErases(0),
+            _occupied(_wordAllocator()), _oldOccupied(_wordAllocator()), _seed(other._seed),
+            _reseedFloor(other._reseedFloor)
+    {
+        _hashTable = _newTable(_capacity);
+        try
+        {
+            _copyBuckets(other);
+        }
+        catch (...)
+        {
+            _deleteTable(_hashTable, _capacity);
+            throw;
+        }
+    }
+
+    /**
+     * move constructor - takes over the tables of the other map in O(1), the other map is left
+     * empty
+     * @param other - HashMap to move from
+     */
+    HashMap(HashMap &&other) noexcept :
+            HashMapMember<Hash, 0>(other._hasher()), HashMapMember<KeyEqual, 1>(other._keyEqual()),
+            HashMapMember<Allocator, 2>(other._allocator()), _capacity(other._capacity),
+            _size(other._size), _hashTable(other._hashTable), _emptyBucket(_nodeAllocator()),
+            _oldTable(other._oldTable),
+            _oldCapacity(other._oldCapacity), _migrated(other._migrated),
+            _rehashStep(other._rehashStep), _policy(other._policy),
+            _minCapacity(other._minCapacity), _lowLoadErases(other._lowLoadErases),
+            _occupied(std::move(other._occupied)), _oldOccupied(std::move(other._oldOccupied)),
+            _seed(other._seed), _reseedFloor(other._reseedFloor)
+    {
+        if (_hashTable == other._emptyTable())
+        {
+            _hashTable = _emptyTable();
+        }
+        other._resetToEmptyTable();
+    }
+
+    /**
+     * HashMap destructor
+     */
+    ~HashMap()
+    {
+        _deleteTable(_oldTable, _oldCapacity);
+        _deleteTable(_hashTable, _capacity);
+        // the bitmaps are freed before the allocator releases its memory, not after this body
+        OccupancyBits(_wordAllocator()).swap(_occupied);
+        OccupancyBits(_wordAllocator()).swap(_oldOccupied);
+        hashMapRelease(_allocator());
+    }
+
+    /**
+     * @return size of the hashMap
+     */
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * @return current capacity of the hashMap
+     */
+    size_t capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    /**
+     * @return true if hashMap is empty
+     */
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the hashMap
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept
+    {
+        return _tryEmplace(_hashCode(key), key, val).second;
+    }
+
+    /**
+     * the function checks if a certain key is already in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept
+    {
+        return !empty() && _findNode(key) != nullptr;
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent. it
+     * checks if a key equal to a value of another type is in the map, without constructing a key
+     * @param key - a value a transparent Hash and KeyEqual take, such as a std::string_view for
+     * std::string keys
+     * @return - true if it does
+     */
+    template<typename K, typename = TransparentKey<K>>
+    bool contains_key(const K &key) const noexcept
+    {
+        return !empty() && _findNode(key) != nullptr;
+    }
+
+    /**
+     * const version of the function - the function gets a key and returns its value. in case the
+     * key is not in the hashMap an exception is thrown.
+     * @param key - the key
+     * @return - key's value
+     */
+    const ValueT &at(const KeyT &key) const noexcept(false)
+    {
+        const pair<KeyT, ValueT> *node = _findNode(key);
+        if (node == nullptr)
+        {
+            throw KeyNotFound{};
+        }
+        return node->second;
+    }
+
+    /**
+     * transparent const version of the function, enabled if Hash and KeyEqual are both
+     * transparent. in case no key equal to the value is in the hashMap an exception is thrown
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return - the value of the key equal to it
+     */
+    template<typename K, typename = TransparentKey<K>>
+    const ValueT &at(const K &key) const noexcept(false)
+    {
+        const pair<KeyT, ValueT> *node = _findNode(key);
+        if (node == nullptr)
+        {
+            throw KeyNotFound{};
+        }
+        return node->second;
+    }
+
+    /**
+     * the function gets a key and returns its value. in case the key is not in the hashMap an
+     * exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT &at(const KeyT &key) noexcept(false)
+    {
+        _migrateStep();
+        Bucket &keyBucket = _bucketAt(_locate(_hashCode(key)));
+        auto it = _findIn(keyBucket, key);
+        if (it == keyBucket.end())
+        {
+            throw KeyNotFound{};
+        }
+        return it->second;
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent. in
+     * case no key equal to the value is in the hashMap an exception is thrown
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return - the value of the key equal to it
+     */
+    template<typename K, typename = TransparentKey<K>>
+    ValueT &at(const K &key) noexcept(false)
+    {
+        _migrateStep();
+        Bucket &keyBucket = _bucketAt(_locate(_hashCodeOf(key)));
+        auto it = _findKeyIn(keyBucket, key);
+        if (it == keyBucket.end())
+        {
+            throw KeyNotFound{};
+        }
+        return it->second;
+    }
+
+    /**
+     * the function gets a key and erases its value
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept
+    {
+        return _eraseKey(key);
+    }
+
+    /**
+     * @return current load factor
+     */
+    double load_factor() const noexcept
+    {
+        return (double) size() / capacity();
+    }
+
+    /**
+     * @return the resize policy
+     */
+    const HashMapPolicy &policy() const noexcept
+    {
+        return _policy;
+    }
+
+    /**
+     * @return the hash function
+     */
+    Hash hash_function() const noexcept(false)
+    {
+        return _hasher();
+    }
+
+    /**
+     * @return the key comparison
+     */
+    KeyEqual key_eq() const noexcept(false)
+    {
+        return _keyEqual();
+    }
+
+    /**
+     * @return the allocator
+     */
+    Allocator get_allocator() const noexcept
+    {
+        return _allocator();
+    }
+
+    /**
+     * sets the resize policy, it is applied from the next insert or erase. a new finalizer
+     * relinks all elements right away
+     * @param policy - the new resize policy
+     */
+    void set_policy(const HashMapPolicy &policy) noexcept(false)
+    {
+        const HashMapPolicy &checked = _checkPolicy(policy);
+        if (checked.finalizer != _policy.finalizer)
+        {
+            SipKey seed = checked.finalizer == HashMapFinalizer::SIPHASH ? randomSipKey() : _seed;
+            _finishMigration();
+            HashMapPolicy previous = _policy;
+            SipKey previousSeed = _seed;
+            _policy = checked;
+            _seed = seed;
+            try
+            {
+                _rehashAll();
+            }
+            catch (...)
+            {
+                _policy = previous;
+                _seed = previousSeed;
+                throw;
+            }
+        }
+        _policy = checked;
+        _lowLoadErases = 0;
+    }
+
+    /**
+     * makes room for a number of elements, so they can be inserted without a rehash. the table
+     * will not shrink under the reserved capacity until shrink_to_fit is called
+     * @param elements - number of elements
+     */
+    void reserve(size_t elements) noexcept(false)
+    {
+        _minCapacity = _fitCapacity(elements);
+        if (_minCapacity > capacity())
+        {
+            _rehash(_minCapacity);
+        }
+    }
+
+    /**
+     * rehashes the map to a given number of buckets, or to the smallest capacity that holds its
+     * current elements, or to the capacity reserve asked for, if it is larger
+     * @param buckets - the wanted capacity, rounded up to a power of two
+     */
+    void rehash(size_t buckets) noexcept(false)
+    {
+        size_t newCapacity = std::max(_fitCapacity(size()), _shrinkFloor());
+        while (newCapacity < buckets)
+        {
+            newCapacity *= 2;
+        }
+        _finishMigration();
+        if (newCapacity != capacity())
+        {
+            _rehash(newCapacity);
+        }
+    }
+
+    /**
+     * drops the capacity reserved by reserve and shrinks the table to the smallest capacity that
+     * holds its current elements
+     */
+    void shrink_to_fit() noexcept(false)
+    {
+        _minCapacity = 0;
+        rehash(0);
+    }
+
+    /**
+     * sets the incremental rehash mode. in this mode a resize only allocates the new table, and
+     * every following insert, erase and at moves the given number of buckets to it, while lookups
+     * check both tables. a step of at least 2 makes sure a rehash is done before the load factor
+     * can trigger the next one
+     * @param bucketsPerStep - buckets moved per operation, 0 goes back to rehashing in one go
+     */
+    void set_rehash_step(size_t bucketsPerStep) noexcept(false)
+    {
+        if (bucketsPerStep == 0)
+        {
+            _finishMigration();
+        }
+        _rehashStep = bucketsPerStep;
+    }
+
+    /**
+     * @return number of buckets moved per operation in incremental rehash mode, 0 if disabled
+     */
+    size_t rehash_step() const noexcept
+    {
+        return _rehashStep;
+    }
+
+    /**
+     * @return true while an incremental rehash is in progress
+     */
+    bool rehashing() const noexcept
+    {
+        return _oldTable != nullptr;
+    }
+
+    /**
+     * the function gets a key and returns it's bucket size. the function throws an exception if
+     * the key was not found
+     * @param key - the key
+     * @return - size of bucket
+     */
+    size_t bucket_size(const KeyT &key) const noexcept(false)
+    {
+        const Bucket &keyBucket = _bucketAt(_locate(_hashCode(key)));
+        if (_findIn(keyBucket, key) == keyBucket.end())
+        {
+            throw KeyNotFound{};
+        }
+        return keyBucket.size();
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return - size of the bucket of the key equal to it
+     */
+    template<typename K, typename = TransparentKey<K>>
+    size_t bucket_size(const K &key) const noexcept(false)
+    {
+        const Bucket &keyBucket = _bucketAt(_locate(_hashCodeOf(key)));
+        if (_findKeyIn(keyBucket, key) == keyBucket.end())
+        {
+            throw KeyNotFound{};
+        }
+        return keyBucket.size();
+    }
+
+    /**
+     * the function gets a key and returns the bucket's index if the map contains the key, or
+     * throws an exception if not. while an incremental rehash is in progress a key that was not
+     * moved yet reports its index in the old table
+     * @param key - the key
+     * @return - bucket index
+     */
+    size_t bucket_index(const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _locate(_hashCode(key));
+        if (_findIn(_bucketAt(idx), key) == _bucketAt(idx).end())
+        {
+            throw KeyNotFound{};
+        }
+        return idx < _oldCapacity ? idx : idx - _oldCapacity;
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return - bucket index of the key equal to it
+     */
+    template<typename K, typename = TransparentKey<K>>
+    size_t bucket_index(const K &key) const noexcept(false)
+    {
+        size_t idx = _locate(_hashCodeOf(key));
+        if (_findKeyIn(_bucketAt(idx), key) == _bucketAt(idx).end())
+        {
+            throw KeyNotFound{};
+        }
+        return idx < _oldCapacity ? idx : idx - _oldCapacity;
+    }
+
+    /**
+     * the function clears the map from all elements, and gives back the memory its allocator
+     * keeps for them (see hashMapRelease)
+     */
+    void clear() noexcept
+    {
+        bool abandon = _abandonsNodes();
+        for (size_t i = _nextOccupied(_oldCapacity); i < _bucketCount();
+             i = _nextOccupied(i + 1))
+        {
+            if (abandon)
+            {
+                ::new((void *) &_hashTable[i - _oldCapacity]) Bucket(_nodeAllocator());
+            }
+            else
+            {
+                _hashTable[i - _oldCapacity].clear();
+            }
+        }
+        std::fill(_occupied.begin(), _occupied.end(), 0);
+        _deleteTable(_oldTable, _oldCapacity);
+        _oldTable = nullptr;
+        _oldCapacity = 0;
+        _migrated = 0;
+        _oldOccupied.clear();
+        _size = 0;
+        hashMapRelease(_allocator());
+    }
+
+    /**
+     * assignment operator
+     * @param other - hashMap to copy elements from
+     * @return reference to HashMap
+     */
+    HashMap &operator=(const HashMap &other) noexcept
+    {
+        if (this != &other)
+        {
+            typedef typename AllocatorTraits::propagate_on_container_copy_assignment Propagate;
+            _copyAllocator(other, Propagate{});
+            _member<Hash, 0>(*this) = other._hasher();
+            _member<KeyEqual, 1>(*this) = other._keyEqual();
+            _resetTable(other.capacity());
+            this->_rehashStep = other._rehashStep;
+            this->_policy = other._policy;
+            this->_minCapacity = other._minCapacity;
+            this->_lowLoadErases = 0;
+            this->_seed = other._seed;
+            this->_reseedFloor = other._reseedFloor;
+            _copyBuckets(other);
+        }
+        return *this;
+    }
+
+    /**
+     * move assignment operator - takes over the tables of the other map in O(1), the other map is
+     * left empty. if the allocator does not move with the tables and the allocators differ, the
+     * elements are moved one by one into tables of this map's allocator
+     * @param other - hashMap to move elements from
+     * @return reference to HashMap
+     */
+    HashMap &operator=(HashMap &&other) noexcept(
+            AllocatorTraits::propagate_on_container_move_assignment::value)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+        if (!AllocatorTraits::propagate_on_container_move_assignment::value &&
+            _allocator() != other._allocator())
+        {
+            HashMap moved(other._policy, other._hasher(), other._keyEqual(), _allocator());
+            moved._rehashStep = other._rehashStep;
+            moved._growTo(moved._fitCapacity(other.size()));
+            for (size_t i = other._nextOccupied(0); i < other._bucketCount();
+                 i = other._nextOccupied(i + 1))
+            {
+                // other is cleared right after, so even its keys can be moved
+                for (auto &tuple : other._bucketAt(i))
+                {
+                    moved._tryEmplace(moved._hashCode(tuple.first), std::move(tuple.first),
+                                      std::move(tuple.second));
+                }
+            }
+            other.clear();
+            swap(moved);
+            return *this;
+        }
+        HashMap moved(std::move(other));
+        swap(moved);
+        // the allocator moves along with the tables even if it does not on swap, so moved frees
+        // the old tables with the allocator that allocated them
+        _swapAllocator(moved, MovesOnlyOnAssignment{});
+        return *this;
+    }
+
+    /**
+     * swaps the contents of two maps in O(1)
+     * @param other - another hashMap
+     */
+    void swap(HashMap &other) noexcept
+    {
+        using std::swap;
+        swap(_member<Hash, 0>(*this), _member<Hash, 0>(other));
+        swap(_member<KeyEqual, 1>(*this), _member<KeyEqual, 1>(other));
+        _swapAllocator(other, typename AllocatorTraits::propagate_on_container_swap{});
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+        std::swap(_hashTable, other._hashTable);
+        // an empty table stays with the map that owns it
+        if (_hashTable == other._emptyTable())
+        {
+            _hashTable = _emptyTable();
+        }
+        if (other._hashTable == _emptyTable())
+        {
+            other._hashTable = other._emptyTable();
+        }
+        std::swap(_oldTable, other._oldTable);
+        std::swap(_oldCapacity, other._oldCapacity);
+        std::swap(_migrated, other._migrated);
+        std::swap(_rehashStep, other._rehashStep);
+        std::swap(_policy, other._policy);
+        std::swap(_minCapacity, other._minCapacity);
+        std::swap(_lowLoadErases, other._lowLoadErases);
+        _swapOccupied(other, MovesOnlyOnAssignment{});
+        std::swap(_seed, other._seed);
+        std::swap(_reseedFloor, other._reseedFloor);
+    }
+
+    /**
+     * swaps the contents of two maps in O(1)
+     * @param first - a hashMap
+     * @param second - another hashMap
+     */
+    friend void swap(HashMap &first, HashMap &second) noexcept
+    {
+        first.swap(second);
+    }
+
+    /**
+     * subscript operator, inserts a default value if the key is not in the map. the key is hashed
+     * and looked up once
+     * @param key
+     * @return
+     */
+    ValueT &operator[](const KeyT &key) noexcept
+    {
+        return _tryEmplace(_hashCode(key), key).first->second;
+    }
+
+    /**
+     * subscript operator, inserts a default value if the key is not in the map
+     * @param key
+     * @return
+     */
+    ValueT &operator[](KeyT &&key) noexcept
+    {
+        size_t code = _hashCode(key);
+        return _tryEmplace(code, std::move(key)).first->second;
+    }
+
+    /**
+     * subscript operator
+     * @param key
+     * @return
+     */
+    ValueT operator[](const KeyT &key) const noexcept
+    {
+        const pair<KeyT, ValueT> *node = _findNode(key);
+        return node == nullptr ? ValueT() : node->second;
+    }
+
+    /**
+     * checks if two hashMaps are identical
+     * @param other - another hashMap
+     * @return true if they are
+     */
+    bool operator==(const HashMap &other) const noexcept
+    {
+        if (this->capacity() != other.capacity() || this->size() != other.size())
+        {
+            return false;
+        }
+        for (size_t i = _nextOccupied(0); i < _bucketCount(); i = _nextOccupied(i + 1))
+        {
+            for (const auto &tuple: _bucketAt(i))
+            {
+                if (!other.contains_key(tuple.first) || other[tuple.first] != tuple.second)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * checks if two hashMaps are not identical
+     * @param other - another hashMap
+     * @return true if they are different
+     */
+    bool operator!=(const HashMap &other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+
+// -------------------------- iterator class -------------------------
+
+    /**
+     * class of a const iterator for HashMap
+     */
+    class ConstIterator
+    {
+        friend class HashMap;
+
+    protected:
+        const HashMap *_map;
+        size_t _curIndex;
+        ConstNodeIterator _cur;
+
+    public:
+        /**
+         * iterator traits:
+         */
+        typedef pair<KeyT, ValueT> value_type;
+        typedef const pair<KeyT, ValueT> *pointer;
+        typedef const pair<KeyT, ValueT> &reference;
+        typedef int difference_type;
+        typedef std::forward_iterator_tag iterator_category;
+
+
+        /**
+         * @return the element pointed to by the iterator, not a copy of it
+         */
+        reference operator*() const
+        {
+            return *_cur;
+        }
+
+        /**
+         * assignment operator for iterator - points to the same HashMap object, same bucket
+         * index and same pair of KeyT, ValueT
+         * @param other
+         * @return
+         */
+        ConstIterator &operator=(const ConstIterator &other)
+        {
+            if (this != &other)
+            {
+                this->_map = other._map;
+                this->_curIndex = other._curIndex;
+                this->_cur = other._cur;
+            }
+            return *this;
+        }
+
+        /**
+         * prefix increment operator
+         * @return
+         */
+        ConstIterator &operator++()
+        {
+            if (++_cur == _map->_bucketAt(_curIndex).end())
+            {
+                _curIndex = _map->_nextOccupied(_curIndex + 1);
+                if (_curIndex < _map->_bucketCount())
+                {
+                    _cur = _map->_bucketAt(_curIndex).begin();
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * postfix increment operator
+         * @return
+         */
+        ConstIterator operator++(int)
+        {
+            ConstIterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * equal operator
+         * @param other - other iterator
+         * @return true if iterators are the same
+         */
+        bool operator==(const ConstIterator &other) const
+        {
+            return this->_map == other._map && this->_curIndex == other._curIndex &&
+                   (_map == nullptr || _curIndex == _map->_bucketCount() || _cur == other._cur);
+        }
+
+        /**
+         * not equal operator
+         * @param other - other iterator
+         * @return true if iterators are not the same
+         */
+        bool operator!=(const ConstIterator &other) const
+        {
+            return !(*this == other);
+        }
+
+        /**
+         * @return pointer to the element pointed to by the iterator
+         */
+        pointer operator->() const
+        {
+            return &(*_cur);
+        }
+
+        ConstIterator() : _map(nullptr), _curIndex(0), _cur()
+        {}
+
+        /**
+         * const iterator constructor
+         * @param node
+         */
+        ConstIterator(const HashMap *hashMap, bool end) : _map(hashMap),
+                                                          _curIndex(0),
+                                                          _cur()
+        {
+            if (end)
+            {
+                _curIndex = _map->_bucketCount();
+            }
+            else
+            {
+                _curIndex = _map->_nextOccupied(0);
+                if (_curIndex < _map->_bucketCount())
+                {
+                    _cur = _map->_bucketAt(_curIndex).begin();
+                }
+            }
+        }
+
+        /**
+         * const iterator constructor for a given node
+         * @param hashMap - the iterated map
+         * @param bucketIndex - index of the node's bucket, old table buckets come first
+         * @param node - the node
+         */
+        ConstIterator(const HashMap *hashMap, size_t bucketIndex, ConstNodeIterator node) :
+                _map(hashMap), _curIndex(bucketIndex), _cur(node)
+        {}
+
+        /**
+         * const iterator copy constructor
+         * @param other
+         */
+        ConstIterator(const ConstIterator &other) : _map(other._map), _curIndex(other._curIndex),
+                                                    _cur(other._cur)
+        {}
+    };
+
+    /**
+     * class of an iterator for HashMap, values can be changed through it. keys can only be read,
+     * they decide the bucket of their pair. dereferencing yields a Reference proxy rather than a
+     * value_type &, so the iterator is only an input iterator and a range for over a non const map
+     * binds its elements with auto && (or const auto &), not auto &
+     */
+    class Iterator : public ConstIterator
+    {
+        friend class HashMap;
+
+    public:
+        /**
+         * an element seen through an Iterator - its key is const and its value can be changed
+         */
+        class Reference
+        {
+        private:
+            const pair<KeyT, ValueT> &_element;
+
+        public:
+            const KeyT &first;
+            ValueT &second;
+
+            explicit Reference(pair<KeyT, ValueT> &element) noexcept :
+                    _element(element), first(element.first), second(element.second)
+            {}
+
+            /**
+             * @return the element, read only
+             */
+            operator const pair<KeyT, ValueT> &() const noexcept
+            {
+                return _element;
+            }
+        };
+
+        /**
+         * the result of operator->, which holds the Reference it points to
+         */
+        class Arrow
+        {
+        private:
+            Reference _reference;
+
+        public:
+            explicit Arrow(const Reference &reference) noexcept : _reference(reference)
+            {}
+
+            const Reference *operator->() const noexcept
+            {
+                return &_reference;
+            }
+        };
+
+        /**
+         * iterator traits:
+         */
+        typedef pair<KeyT, ValueT> value_type;
+        typedef Arrow pointer;
+        typedef Reference reference;
+        typedef int difference_type;
+        typedef std::input_iterator_tag iterator_category;
+
+        /**
+         * @return the element pointed to by the iterator
+         */
+        reference operator*() const
+        {
+            // the nodes belong to a map that is not const
+            return Reference(const_cast<pair<KeyT, ValueT> &>(*this->_cur));
+        }
+
+        /**
+         * @return pointer to the element pointed to by the iterator
+         */
+        pointer operator->() const
+        {
+            return Arrow(**this);
+        }
+
+        /**
+         * prefix increment operator
+         * @return
+         */
+        Iterator &operator++()
+        {
+            ConstIterator::operator++();
+            return *this;
+        }
+
+        /**
+         * postfix increment operator
+         * @return
+         */
+        Iterator operator++(int)
+        {
+            Iterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        Iterator() : ConstIterator()
+        {}
+
+        /**
+         * iterator constructor
+         * @param hashMap - the iterated map
+         * @param end - true for the end iterator, false for the first element
+         */
+        Iterator(HashMap *hashMap, bool end) : ConstIterator(hashMap, end)
+        {}
+
+        /**
+         * iterator constructor for a given node
+         * @param hashMap - the iterated map
+         * @param bucketIndex - index of the node's bucket, old table buckets come first
+         * @param node - the node
+         */
+        Iterator(HashMap *hashMap, size_t bucketIndex, NodeIterator node) :
+                ConstIterator(hashMap, bucketIndex, node)
+        {}
+    };
+
+    typedef ConstIterator const_iterator;
+    typedef Iterator iterator;
+
+    const_iterator begin() const
+    {
+        return ConstIterator(this, false);
+    }
+
+    const_iterator end() const
+    {
+        return ConstIterator(this, true);
+    }
+
+    iterator begin()
+    {
+        return Iterator(this, false);
+    }
+
+    iterator end()
+    {
+        return Iterator(this, true);
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    /**
+     * the function looks a key up
+     * @param key - the key
+     * @return iterator to the key's pair, or end() if the key is not in the map
+     */
+    const_iterator find(const KeyT &key) const noexcept
+    {
+        size_t idx = _locate(_hashCode(key));
+        auto it = _findIn(_bucketAt(idx), key);
+        return it == _bucketAt(idx).end() ? end() : const_iterator(this, idx, it);
+    }
+
+    /**
+     * the function looks a key up
+     * @param key - the key
+     * @return iterator to the key's pair, or end() if the key is not in the map
+     */
+    iterator find(const KeyT &key) noexcept
+    {
+        size_t idx = _locate(_hashCode(key));
+        auto it = _findIn(_bucketAt(idx), key);
+        return it == _bucketAt(idx).end() ? end() : iterator(this, idx, it);
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return iterator to the pair of the key equal to it, or end() if there is none
+     */
+    template<typename K, typename = TransparentKey<K>>
+    const_iterator find(const K &key) const noexcept
+    {
+        size_t idx = _locate(_hashCodeOf(key));
+        auto it = _findKeyIn(_bucketAt(idx), key);
+        return it == _bucketAt(idx).end() ? end() : const_iterator(this, idx, it);
+    }
+
+    /**
+     * transparent version of the function, enabled if Hash and KeyEqual are both transparent
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return iterator to the pair of the key equal to it, or end() if there is none
+     */
+    template<typename K, typename = TransparentKey<K>>
+    iterator find(const K &key) noexcept
+    {
+        size_t idx = _locate(_hashCodeOf(key));
+        auto it = _findKeyIn(_bucketAt(idx), key);
+        return it == _bucketAt(idx).end() ? end() : iterator(this, idx, it);
+    }
+
+    /**
+     * transparent version of erase(const KeyT &), enabled if Hash and KeyEqual are both
+     * transparent. an iterator is left to erase(const_iterator)
+     * @param key - a value a transparent Hash and KeyEqual take
+     * @return - true if a key equal to it was erased
+     */
+    template<typename K, typename = TransparentKey<K>, typename = typename std::enable_if<
+            !std::is_convertible<K, const_iterator>::value>::type>
+    bool erase(const K &key) noexcept
+    {
+        return _eraseKey(key);
+    }
+
+    /**
+     * erases the element an iterator points to. the table is not resized and no bucket of an
+     * incremental rehash is moved, so the other iterators stay valid and a scan can go on from the
+     * returned iterator. the table shrinks on a later erase of a key, or on shrink_to_fit
+     * @param pos - iterator to an element of the map
+     * @return iterator to the element after the erased one
+     */
+    iterator erase(const_iterator pos) noexcept
+    {
+        Bucket &keyBucket = _bucketAt(pos._curIndex);
+        iterator next(this, pos._curIndex, keyBucket.erase(pos._cur));
+        _size--;
+        _updateOccupied(pos._curIndex);
+        if (next._cur == keyBucket.end())
+        {
+            next._curIndex = _nextOccupied(pos._curIndex + 1);
+            if (next._curIndex < _bucketCount())
+            {
+                next._cur = _bucketAt(next._curIndex).begin();
+            }
+        }
+        return next;
+    }
+
+    /**
+     * erases every element a predicate holds for, in one pass over the non empty buckets. the
+     * table shrinks at most once, after the pass
+     * @param pred - called with a const pair<KeyT, ValueT> &
+     * @return number of erased elements
+     */
+    template<typename Predicate>
+    size_t erase_if(Predicate pred) noexcept(false)
+    {
+        size_t before = _size;
+        for (size_t i = _nextOccupied(0); i < _bucketCount(); i = _nextOccupied(i + 1))
+        {
+            Bucket &keyBucket = _bucketAt(i);
+            size_t bucketSize = keyBucket.size();
+            keyBucket.remove_if([&pred](const pair<KeyT, ValueT> &t) { return pred(t); });
+            _size -= bucketSize - keyBucket.size();
+            _updateOccupied(i);
+        }
+        _lowLoadErases = 0;
+        if (_size < before && _lowerLoadFactor() && capacity() > _shrinkFloor())
+        {
+            size_t newCapacity = _fitCapacity(_size);
+            _rehash(newCapacity > _shrinkFloor() ? newCapacity : _shrinkFloor());
+        }
+        return before - _size;
+    }
+
+    /**
+     * looks up a batch of keys, prefetching the buckets of a whole group of keys before any of
+     * them is searched
+     * @param first - beginning of the keys, a forward iterator over KeyT lvalues
+     * @param last - end of the keys
+     * @param out - receives for every key an iterator to its pair, or end() if it is not in the map
+     * @return out after the last written iterator
+     */
+    template<typename KeyIterator, typename OutputIterator>
+    OutputIterator find_many(KeyIterator first, KeyIterator last,
+                             OutputIterator out) const noexcept(false)
+    {
+        _lookupMany(first, last, [this, &out](size_t idx, const Bucket &keyBucket,
+                                              ConstNodeIterator node)
+        {
+            *out++ = node == keyBucket.end() ? end() : const_iterator(this, idx, node);
+        });
+        return out;
+    }
+
+    /**
+     * checks a batch of keys, prefetching the buckets of a whole group of keys before any of them
+     * is searched
+     * @param first - beginning of the keys, a forward iterator over KeyT lvalues
+     * @param last - end of the keys
+     * @param out - receives for every key true if it is in the map
+     * @return out after the last written result
+     */
+    template<typename KeyIterator, typename OutputIterator>
+    OutputIterator contains_many(KeyIterator first, KeyIterator last,
+                                 OutputIterator out) const noexcept(false)
+    {
+        _lookupMany(first, last, [&out](size_t, const Bucket &keyBucket,
+                                        ConstNodeIterator node)
+        {
+            *out++ = node != keyBucket.end();
+        });
+        return out;
+    }
+
+    /**
+     * gets the values of a batch of keys, prefetching the buckets of a whole group of keys before
+     * any of them is searched. in case a key is not in the map an exception is thrown, after the
+     * values of the keys before it were written
+     * @param first - beginning of the keys, a forward iterator over KeyT lvalues
+     * @param last - end of the keys
+     * @param out - receives the value of every key
+     * @return out after the last written value
+     */
+    template<typename KeyIterator, typename OutputIterator>
+    OutputIterator at_many(KeyIterator first, KeyIterator last,
+                           OutputIterator out) const noexcept(false)
+    {
+        _lookupMany(first, last, [&out](size_t, const Bucket &keyBucket,
+                                        ConstNodeIterator node)
+        {
+            if (node == keyBucket.end())
+            {
+                throw KeyNotFound{};
+            }
+            *out++ = node->second;
+        });
+        return out;
+    }
+
+    /**
+     * inserts the pairs of a range, a key that is already in the map keeps its value. a range
+     * that can be measured makes the table grow at most once
+     * @tparam InputIterator - iterator over pairs of key and value
+     * @param first - beginning of the range
+     * @param last - end of the range
+     */
+    template<typename InputIterator,
+            typename = decltype((*std::declval<InputIterator &>()).second)>
+    void insert(InputIterator first, InputIterator last) noexcept(false)
+    {
+        _reserveRange(first, last,
+                      typename std::iterator_traits<InputIterator>::iterator_category{});
+        for (; first != last; ++first)
+        {
+            _tryEmplace(_hashCode((*first).first), (*first).first, (*first).second);
+        }
+    }
+
+    /**
+     * inserts a range of another HashMap. a whole map inserted into an empty one is copied in
+     * bucket order without looking any key up
+     * @param first - beginning of the range
+     * @param last - end of the range
+     */
+    void insert(const_iterator first, const_iterator last) noexcept(false)
+    {
+        if (first == last)
+        {
+            return;
+        }
+        const HashMap *other = first._map;
+        if (other != this && empty() && first == other->begin() && last == other->end())
+        {
+            _insertAll(*other);
+            return;
+        }
+        _growTo(_fitCapacity(size() + (other == this ? 0 : other->size())));
+        for (; first != last; ++first)
+        {
+            _tryEmplace(_hashCode(first->first), first->first, first->second);
+        }
+    }
+
+    /**
+     * inserts a range of another HashMap, like the const_iterator version
+     * @param first - beginning of the range
+     * @param last - end of the range
+     */
+    void insert(iterator first, iterator last) noexcept(false)
+    {
+        insert(const_iterator(first), const_iterator(last));
+    }
+
+    /**
+     * inserts a key with a value constructed from args, if the key is not in the map yet. the
+     * key is hashed and looked up once, and args are untouched if the key is found
+     * @param key - the key
+     * @param args - arguments for the value constructor
+     * @return iterator to the key's pair, and true if it was inserted
+     */
+    template<typename... Args>
+    pair<iterator, bool> try_emplace(const KeyT &key, Args &&... args) noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        auto res = _tryEmplace(code, key, std::forward<Args>(args)...);
+        return {iterator(this, _indexOf(res.first, code), res.first), res.second};
+    }
+
+    /**
+     * inserts a key with a value constructed from args, if the key is not in the map yet. the
+     * key is hashed and looked up once, and it is moved from only if it is inserted
+     * @param key - the key
+     * @param args - arguments for the value constructor
+     * @return iterator to the key's pair, and true if it was inserted
+     */
+    template<typename... Args>
+    pair<iterator, bool> try_emplace(KeyT &&key, Args &&... args) noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        auto res = _tryEmplace(code, std::move(key), std::forward<Args>(args)...);
+        return {iterator(this, _indexOf(res.first, code), res.first), res.second};
+    }
+
+    /**
+     * inserts a key with a value, or assigns the value if the key is already in the map. the key
+     * is hashed and looked up once
+     * @param key - the key
+     * @param obj - the value
+     * @return iterator to the key's pair, and true if it was inserted
+     */
+    template<typename M>
+    pair<iterator, bool> insert_or_assign(const KeyT &key, M &&obj) noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        auto res = _insertOrAssign(code, key, std::forward<M>(obj));
+        return {iterator(this, _indexOf(res.first, code), res.first), res.second};
+    }
+
+    /**
+     * inserts a key with a value, or assigns the value if the key is already in the map. the key
+     * is hashed and looked up once
+     * @param key - the key
+     * @param obj - the value
+     * @return iterator to the key's pair, and true if it was inserted
+     */
+    template<typename M>
+    pair<iterator, bool> insert_or_assign(KeyT &&key, M &&obj) noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        auto res = _insertOrAssign(code, std::move(key), std::forward<M>(obj));
+        return {iterator(this, _indexOf(res.first, code), res.first), res.second};
+    }
+
+    /**
+     * constructs a pair from args and inserts it if its key is not in the map yet. the pair is
+     * built in a detached node, which is linked into its bucket without another allocation
+     * @param args - arguments for the pair constructor
+     * @return iterator to the key's pair, and true if it was inserted
+     */
+    template<typename... Args>
+    pair<iterator, bool> emplace(Args &&... args) noexcept(false)
+    {
+        Bucket node(_nodeAllocator());
+        node.emplace_back(std::forward<Args>(args)...);
+        _ensureTable();
+        size_t code = _hashCode(node.front().first);
+        size_t idx = _locate(code);
+        Bucket &keyBucket = _bucketAt(idx);
+        auto it = _findIn(keyBucket, node.front().first);
+        if (it == keyBucket.end())
+        {
+            it = node.begin();
+            keyBucket.splice(keyBucket.end(), node);
+            _afterInsert(idx);
+            return {iterator(this, _indexOf(it, code), it), true};
+        }
+        return {iterator(this, idx, it), false};
+    }
+
+    /**
+     * inserts a key with init if it is not in the map yet, otherwise updates its value in place.
+     * the key is hashed and looked up once
+     * @param key - the key
+     * @param init - value of the key if it is inserted
+     * @param fn - called with a ValueT & if the key is already in the map
+     * @return the key's value
+     */
+    template<typename Function>
+    ValueT &upsert(const KeyT &key, const ValueT &init, Function fn) noexcept(false)
+    {
+        auto res = _tryEmplace(_hashCode(key), key, init);
+        if (!res.second)
+        {
+            fn(res.first->second);
+        }
+        return res.first->second;
+    }
+
+    /**
+     * updates the value of a key in place, if the key is in the map. the key is hashed and
+     * looked up once
+     * @param key - the key
+     * @param fn - called with a ValueT & if the key is in the map
+     * @return true if the key is in the map
+     */
+    template<typename Function>
+    bool compute_if_present(const KeyT &key, Function fn) noexcept(false)
+    {
+        if (empty())
+        {
+            return false;
+        }
+        Bucket &keyBucket = _bucketAt(_locate(_hashCode(key)));
+        auto it = _findIn(keyBucket, key);
+        if (it == keyBucket.end())
+        {
+            return false;
+        }
+        fn(it->second);
+        return true;
+    }
+
+    /**
+     * calls a function with every element, on the threads of an executor. the bucket range is
+     * split into chunks, which the executor's threads share
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain), such as a
+     * WorkStealingPool
+     * @param fn - called with a const pair<KeyT, ValueT> &, possibly from several threads at once
+     */
+    template<typename Executor, typename Function>
+    void parallel_for_each(Executor &executor, Function fn) const noexcept(false)
+    {
+        executor.parallel_for(0, _bucketCount(), [this, &fn](size_t first, size_t last)
+                              {
+                                  for (size_t i = first; i < last; i++)
+                                  {
+                                      for (const auto &tuple: _bucketAt(i))
+                                      {
+                                          fn(tuple);
+                                      }
+                                  }
+                              }, PARALLEL_BUCKET_GRAIN);
+    }
+
+    /**
+     * maps every element to a T and combines the results, on the threads of an executor. the
+     * buckets are reduced in blocks, and the blocks are combined in bucket order, so the result
+     * does not depend on the scheduling
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
+     * @param identity - the result of an empty map
+     * @param map - called with a const pair<KeyT, ValueT> &, returns a T
+     * @param reduce - combines two T
+     * @return the combined result
+     */
+    template<typename Executor, typename T, typename Map, typename Reduce>
+    T parallel_reduce(Executor &executor, T identity, Map map, Reduce reduce) const noexcept(false)
+    {
+        size_t buckets = _bucketCount();
+        size_t blocks = buckets < PARALLEL_REDUCE_BLOCKS ? buckets : PARALLEL_REDUCE_BLOCKS;
+        std::vector<T> partial(blocks, identity);
+        executor.parallel_for(0, blocks, [&](size_t first, size_t last)
+                              {
+                                  for (size_t block = first; block < last; block++)
+                                  {
+                                      size_t end = buckets * (block + 1) / blocks;
+                                      for (size_t i = buckets * block / blocks; i < end; i++)
+                                      {
+                                          for (const auto &tuple: _bucketAt(i))
+                                          {
+                                              partial[block] = reduce(partial[block], map(tuple));
+                                          }
+                                      }
+                                  }
+                              });
+        T result = identity;
+        for (const T &blockResult : partial)
+        {
+            result = reduce(result, blockResult);
+        }
+        return result;
+    }
+
+    /**
+     * erases every element a predicate holds for, on the threads of an executor. an incremental
+     * rehash in progress is finished first. every thread erases from the non empty buckets of its
+     * own words of the occupancy bitmap, and the table shrinks at most once, at the end. erasing
+     * frees the nodes, so with an allocator that is not safe to use from several threads at once
+     * (see hashMapConcurrent) this is erase_if, on the calling thread
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
+     * @param pred - called with a const pair<KeyT, ValueT> &, possibly from several threads at
+     * once
+     * @return number of erased elements
+     */
+    template<typename Executor, typename Predicate>
+    size_t parallel_erase_if(Executor &executor, Predicate pred) noexcept(false)
+    {
+        if (!hashMapConcurrent(_allocator()))
+        {
+            return erase_if(pred);
+        }
+        _finishMigration();
+        std::atomic<size_t> erased(0);
+        executor.parallel_for(0, _occupied.size(), [this, &pred, &erased](size_t first,
+                                                                          size_t last)
+                              {
+                                  size_t count = 0;
+                                  size_t end = last * OCCUPANCY_WORD_BITS < _capacity ?
+                                               last * OCCUPANCY_WORD_BITS : _capacity;
+                                  for (size_t i = _scanOccupied(_occupied,
+                                                                first * OCCUPANCY_WORD_BITS, end);
+                                       i < end; i = _scanOccupied(_occupied, i + 1, end))
+                                  {
+                                      size_t before = _hashTable[i].size();
+                                      _hashTable[i].remove_if(
+                                              [&pred](const pair<KeyT, ValueT> &t)
+                                              { return pred(t); });
+                                      count += before - _hashTable[i].size();
+                                      _setOccupied(_occupied, i, !_hashTable[i].empty());
+                                  }
+                                  erased.fetch_add(count);
+                              }, PARALLEL_BUCKET_GRAIN / OCCUPANCY_WORD_BITS);
+        _size -= erased.load();
+        _lowLoadErases = 0;
+        if (erased.load() > 0 && _lowerLoadFactor() && capacity() > _shrinkFloor())
+        {
+            size_t newCapacity = _fitCapacity(_size);
+            parallel_rehash(executor, newCapacity > _shrinkFloor() ? newCapacity : _shrinkFloor());
+        }
+        return erased.load();
+    }
+
+    /**
+     * rehashes the map like rehash, on the threads of an executor. when growing, every old bucket
+     * feeds its own set of new buckets, and when shrinking every new bucket takes whole old
+     * buckets, so the threads never touch the same bucket and no node is copied
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
+     * @param buckets - the wanted capacity, rounded up to a power of two
+     */
+    template<typename Executor>
+    void parallel_rehash(Executor &executor, size_t buckets) noexcept(false)
+    {
+        size_t newCapacity = std::max(_fitCapacity(size()), _shrinkFloor());
+        while (newCapacity < buckets)
+        {
+            newCapacity *= 2;
+        }
+        _finishMigration();
+        if (newCapacity == capacity())
+        {
+            return;
+        }
+        if (_hashTable == _emptyTable())
+        {
+            _rehash(newCapacity);
+            return;
+        }
+        OccupancyBits newOccupied(_occupancyWords(newCapacity), 0, _wordAllocator());
+        auto *newMap = _newTable(newCapacity);
+        size_t oldCapacity = capacity();
+        if (newCapacity > oldCapacity)
+        {
+            executor.parallel_for(0, oldCapacity, [this, newMap, newCapacity](size_t first,
+                                                                             size_t last)
+                                  {
+                                      for (size_t i = _scanOccupied(_occupied, first, last);
+                                           i < last; i = _scanOccupied(_occupied, i + 1, last))
+                                      {
+                                          _relinkBucket(_hashTable[i], newMap, newCapacity,
+                                                        nullptr);
+                                      }
+                                  }, PARALLEL_BUCKET_GRAIN);
+        }
+        else
+        {
+            executor.parallel_for(0, newCapacity, [this, newMap, newCapacity,
+                                                   oldCapacity](size_t first, size_t last)
+                                  {
+                                      for (size_t i = first; i < last; i++)
+                                      {
+                                          for (size_t j = i; j < oldCapacity; j += newCapacity)
+                                          {
+                                              newMap[i].splice(newMap[i].end(), _hashTable[j]);
+                                          }
+                                      }
+                                  }, PARALLEL_BUCKET_GRAIN);
+        }
+        _deleteTable(_hashTable, _capacity);
+        _hashTable = newMap;
+        _capacity = newCapacity;
+        _occupied.swap(newOccupied);
+        _parallelRefreshOccupied(executor);
+    }
+
+    /**
+     * builds a map from matching keys and values on several threads. the table is sized once,
+     * the pairs are hashed in parallel, and their indices are scattered by the range of buckets
+     * they fall in (a stable radix pass, so every range keeps the input order). every thread then
+     * links the pairs of its own range of buckets, without locking. like the iterator
+     * constructor, the last value of a repeated key wins. the pairs are split in as many parts as
+     * the hardware has threads (at most the capacity), and every step runs the parts on the
+     * threads of an executor. linking allocates the nodes, so with an allocator that is not safe
+     * to use from several threads at once (see hashMapConcurrent), such as a pmr map on a
+     * monotonic_buffer_resource or unsynchronized_pool_resource, the parts are linked one after
+     * the other on the calling thread
+     * @param executor - has parallel_for(begin, end, fn(chunkBegin, chunkEnd), grain)
+     * @param keys - the keys, indexable with []
+     * @param values - the values, indexable with []
+     * @param policy - the resize policy of the map
+     * @param allocator - the allocator, needed for an allocator that is not default constructible
+     * @return the map
+     */
+    template<typename Executor, typename Keys, typename Values>
+    static HashMap build_parallel(Executor &executor, const Keys &keys, const Values &values,
+                                  const HashMapPolicy &policy = HashMapPolicy{},
+                                  const Allocator &allocator = Allocator()) noexcept(false)
+    {
+        size_t pairs = keys.size();
+        if (pairs != values.size())
+        {
+            throw VectorsLength{};
+        }
+        HashMap map(policy, Hash(), KeyEqual(), allocator);
+        map._growTo(map._fitCapacity(pairs));
+        size_t cap = map.capacity();
+        size_t parts = std::thread::hardware_concurrency();
+        if (parts == 0)
+        {
+            parts = 1;
+        }
+        if (parts > cap)
+        {
+            parts = cap;
+        }
+        std::vector<size_t> codes(pairs);
+        std::vector<size_t> counts(parts * parts, 0);
+        // a pair of bucket b belongs to the thread building buckets [p * cap / parts, ...)
+        auto partOf = [cap, parts](size_t code)
+        {
+            return (code & (cap - 1)) * parts / cap;
+        };
+        auto hashPairs = [&](size_t t)
+        {
+            for (size_t i = pairs * t / parts; i < pairs * (t + 1) / parts; i++)
+            {
+                codes[i] = map._hashCode(keys[i]);
+                counts[t * parts + partOf(codes[i])]++;
+            }
+        };
+        _runParts(executor, parts, hashPairs);
+        std::vector<size_t> offsets(parts * parts);
+        size_t offset = 0;
+        for (size_t p = 0; p < parts; p++)
+        {
+            for (size_t t = 0; t < parts; t++)
+            {
+                offsets[t * parts + p] = offset;
+                offset += counts[t * parts + p];
+            }
+        }
+        std::vector<size_t> order(pairs);
+        auto scatterPairs = [&](size_t t)
+        {
+            for (size_t i = pairs * t / parts; i < pairs * (t + 1) / parts; i++)
+            {
+                order[offsets[t * parts + partOf(codes[i])]++] = i;
+            }
+        };
+        _runParts(executor, parts, scatterPairs);
+        std::vector<size_t> inserted(parts, 0);
+        auto linkPairs = [&](size_t p)
+        {
+            size_t first = p == 0 ? 0 : offsets[(parts - 1) * parts + p - 1];
+            size_t last = offsets[(parts - 1) * parts + p];
+            for (size_t j = first; j < last; j++)
+            {
+                size_t i = order[j];
+                Bucket &keyBucket = map._hashTable[codes[i] & (cap - 1)];
+                auto it = map._findIn(keyBucket, keys[i]);
+                if (it != keyBucket.end())
+                {
+                    it->second = values[i];
+                }
+                else
+                {
+                    keyBucket.emplace_back(keys[i], values[i]);
+                    inserted[p]++;
+                }
+            }
+        };
+        if (hashMapConcurrent(map._allocator()))
+        {
+            _runParts(executor, parts, linkPairs);
+        }
+        else
+        {
+            for (size_t p = 0; p < parts; p++)
+            {
+                linkPairs(p);
+            }
+        }
+        size_t words = map._occupied.size();
+        auto markBuckets = [&](size_t p)
+        {
+            map._refreshOccupied(words * p / parts, words * (p + 1) / parts);
+        };
+        _runParts(executor, parts, markBuckets);
+        for (size_t count : inserted)
+        {
+            map._size += count;
+        }
+        return map;
+    }
+};
+
+/**
+ * HashMap whose list nodes come from a NodePool, the one of the NodePoolAllocator it is
+ * constructed with
+ */
+template<typename KeyT, typename ValueT, typename Hash = std::hash<KeyT>,
+        typename KeyEqual = std::equal_to<KeyT>>
+using PooledHashMap = HashMap<KeyT, ValueT, Hash, KeyEqual, NodePoolAllocator<pair<KeyT, ValueT>>>;
+
+#if __cplusplus >= 201703L
+
+namespace pmr
+{
+    /**
+     * HashMap whose bucket tables and nodes come from a std::pmr::memory_resource. with a
+     * monotonic_buffer_resource, clear() and the destructor leave trivially destructible nodes to
+     * the resource instead of freeing them one by one
+     */
+    template<typename KeyT, typename ValueT, typename Hash = std::hash<KeyT>,
+            typename KeyEqual = std::equal_to<KeyT>>
+    using HashMap = ::HashMap<KeyT, ValueT, Hash, KeyEqual,
+            std::pmr::polymorphic_allocator<pair<KeyT, ValueT>>>;
+}
+
+#endif
 
 #endif //EX6_HASHMAP_HPP
@@ -0,0 +1,182 @@
+#ifndef EX6_HASHMIX_HPP
+#define EX6_HASHMIX_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <type_traits>
+#include <random>
+
+// -------------------------- const definitions -------------------------
+#define SIP_COMPRESSION_ROUNDS 2
+#define SIP_FINALIZATION_ROUNDS 4
+
+// ------------------------------ functions -----------------------------
+/**
+ * murmur3 64 bit finalizer - spreads the entropy of a hash value over all of its bits. the open
+ * addressing maps take both the probe start and the fingerprint from the same hash value, so an
+ * identity std::hash (as for integers) must be mixed before use
+ * @param h - the raw hash value
+ * @return the mixed hash value
+ */
+inline size_t mixHash(size_t h) noexcept
+{
+    uint64_t x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (size_t) x;
+}
+
+/**
+ * fibonacci hashing - multiplies by 2^64 divided by the golden ratio, which leaves the entropy in
+ * the high bits of the product, and folds them into the low bits that a power of two mask keeps.
+ * cheaper than mixHash, and keys with a power of two stride no longer share their low bits
+ * @param h - the raw hash value
+ * @return the mixed hash value
+ */
+inline size_t fibonacciHash(size_t h) noexcept
+{
+    uint64_t x = (uint64_t) h * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 32;
+    return (size_t) x;
+}
+
+/**
+ * the secret key of sipHash
+ */
+struct SipKey
+{
+    uint64_t k0;
+    uint64_t k1;
+};
+
+/**
+ * @return a key drawn from std::random_device
+ */
+inline SipKey randomSipKey() noexcept(false)
+{
+    std::random_device device;
+    SipKey key{};
+    key.k0 = ((uint64_t) device() << 32) ^ device();
+    key.k1 = ((uint64_t) device() << 32) ^ device();
+    return key;
+}
+
+/**
+ * @param x - a word
+ * @param bits - rotation, in (0, 64)
+ * @return x rotated left
+ */
+inline uint64_t sipRotate(uint64_t x, unsigned bits) noexcept
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+/**
+ * one SipRound on the state
+ */
+inline void sipRound(uint64_t &v0, uint64_t &v1, uint64_t &v2, uint64_t &v3) noexcept
+{
+    v0 += v1;
+    v1 = sipRotate(v1, 13);
+    v1 ^= v0;
+    v0 = sipRotate(v0, 32);
+    v2 += v3;
+    v3 = sipRotate(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3 = sipRotate(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1 = sipRotate(v1, 17);
+    v1 ^= v2;
+    v2 = sipRotate(v2, 32);
+}
+
+/**
+ * SipHash-2-4, a keyed hash. without the key, inputs that collide can not be found faster than by
+ * trying, so a map hashing outside input with a secret random key keeps its chains short
+ * @param data - the bytes to hash
+ * @param length - number of bytes
+ * @param key - the secret key
+ * @return the hash of the bytes
+ */
+inline uint64_t sipHash(const void *data, size_t length, const SipKey &key) noexcept
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t v0 = key.k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = key.k1 ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = key.k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = key.k1 ^ 0x7465646279746573ULL;
+    size_t whole = length - length % 8;
+    for (size_t i = 0; i <= whole; i += 8)
+    {
+        // the last word holds the remaining bytes and the length in its top byte
+        uint64_t word = i == whole ? (uint64_t) length << 56 : 0;
+        size_t count = i == whole ? length % 8 : 8;
+        for (size_t j = 0; j < count; j++)
+        {
+            word |= (uint64_t) bytes[i + j] << (8 * j);
+        }
+        v3 ^= word;
+        for (int round = 0; round < SIP_COMPRESSION_ROUNDS; round++)
+        {
+            sipRound(v0, v1, v2, v3);
+        }
+        v0 ^= word;
+    }
+    v2 ^= 0xff;
+    for (int round = 0; round < SIP_FINALIZATION_ROUNDS; round++)
+    {
+        sipRound(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ * sipHash of a string's characters
+ * @param value - the string
+ * @param key - the secret key
+ * @return the hash
+ */
+inline uint64_t sipHashOf(const std::string &value, const SipKey &key) noexcept
+{
+    return sipHash(value.data(), value.size(), key);
+}
+
+/**
+ * sipHash of an integer, enum or pointer, whose equal values have equal bytes
+ * @param value - the value
+ * @param key - the secret key
+ * @return the hash
+ */
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value ||
+                        std::is_pointer<T>::value, uint64_t>::type
+sipHashOf(const T &value, const SipKey &key) noexcept
+{
+    return sipHash(&value, sizeof(value), key);
+}
+
+/**
+ * sipHash of the std::hash of any other value (floating point zeros or class types may be equal
+ * with different bytes). the result is only as hard to collide as std::hash of the type
+ * @param value - the value
+ * @param key - the secret key
+ * @return the hash
+ */
+template<typename T>
+typename std::enable_if<!std::is_integral<T>::value && !std::is_enum<T>::value &&
+                        !std::is_pointer<T>::value, uint64_t>::type
+sipHashOf(const T &value, const SipKey &key) noexcept
+{
+    size_t code = std::hash<T>{}(value);
+    return sipHash(&code, sizeof(code), key);
+}
+
+#endif //EX6_HASHMIX_HPP
@@ -0,0 +1,345 @@
+#ifndef EX6_LEFTRIGHTHASHMAP_HPP
+#define EX6_LEFTRIGHTHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include "HashMap.hpp"
+#include "Epoch.hpp"
+
+// -------------------------- const definitions -------------------------
+#define LEFT_RIGHT_SLOT_SIZE 64
+
+// ------------------------------ functions -----------------------------
+/**
+ * HashMap containing KeyT and ValueT for one writer and many readers (the left-right technique).
+ * two HashMap instances hold the same elements. readers use the instance the writer is not
+ * touching, announcing themselves only in a counter of their own, so they never wait and never
+ * write a cache line shared with another thread. the writer applies a change to the other
+ * instance, flips the readers over to it, waits until no reader is left on the old one, and
+ * replays the change there. writers are serialized by a mutex
+ */
+template<typename KeyT, typename ValueT>
+class LeftRightHashMap
+{
+private:
+    /**
+     * the read counters of one thread, one per version. fills a cache line so two threads never
+     * write the same line
+     */
+    struct ReadSlot
+    {
+        std::atomic<size_t> readers[2];
+        char padding[LEFT_RIGHT_SLOT_SIZE - 2 * sizeof(std::atomic<size_t>)];
+    };
+
+    /**
+     * the two instances
+     */
+    HashMap<KeyT, ValueT> _maps[2];
+    /**
+     * index of the instance the readers use
+     */
+    std::atomic<size_t> _readIndex;
+    /**
+     * index of the read counter new readers announce themselves in
+     */
+    std::atomic<size_t> _versionIndex;
+    /**
+     * read counters of each thread, by EpochThreadIndex
+     */
+    std::unique_ptr<ReadSlot[]> _slots;
+    /**
+     * serializes the writers
+     */
+    std::mutex _writeLock;
+
+    /**
+     * @return the read counters of the calling thread
+     */
+    ReadSlot &_ownSlot() const noexcept(false)
+    {
+        size_t index = EpochThreadIndex::current();
+        if (index >= EPOCH_MAX_THREADS)
+        {
+            throw TooManyThreads{};
+        }
+        return _slots[index];
+    }
+
+    /**
+     * waits until no reader is announced in a version
+     * @param version - the version
+     */
+    void _waitForReaders(size_t version) const noexcept
+    {
+        for (size_t i = 0; i < EPOCH_MAX_THREADS; i++)
+        {
+            while (_slots[i].readers[version].load(std::memory_order_seq_cst) != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * applies a change to the instance the readers do not use. if it throws, the instance is
+     * copied back from the one they use and the exception is rethrown
+     * @param fn - the change
+     * @param readIndex - index of the instance the readers use
+     * @return what fn returned
+     */
+    template<typename Function>
+    auto _writeFirst(Function &fn, size_t readIndex) ->
+    decltype(fn(std::declval<HashMap<KeyT, ValueT> &>()))
+    {
+        try
+        {
+            return fn(_maps[1 - readIndex]);
+        }
+        catch (...)
+        {
+            _maps[1 - readIndex] = _maps[readIndex];
+            throw;
+        }
+    }
+
+    /**
+     * applies a change to both instances, the write lock must be held
+     * @param fn - called with a HashMap<KeyT, ValueT> &, must change both instances the same way
+     * @return what fn returned on the first instance. if fn throws on the first instance, before
+     * the flip, that instance is copied back from the one the readers use and the exception is
+     * rethrown - the change is dropped. if it throws on the second instance, after the flip, that
+     * instance is copied from the first one and the exception is rethrown - the change stays
+     * applied. either way the instances never differ (HashMap's copy assignment is noexcept)
+     */
+    template<typename Function>
+    auto _write(Function fn) -> decltype(fn(std::declval<HashMap<KeyT, ValueT> &>()))
+    {
+        size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+        auto result = _writeFirst(fn, readIndex);
+        _readIndex.store(1 - readIndex, std::memory_order_seq_cst);
+        size_t version = _versionIndex.load(std::memory_order_relaxed);
+        _waitForReaders(1 - version);
+        _versionIndex.store(1 - version, std::memory_order_seq_cst);
+        _waitForReaders(version);
+        try
+        {
+            fn(_maps[readIndex]);
+        }
+        catch (...)
+        {
+            // the readers already see the change, bring the other instance level with it
+            _maps[readIndex] = _maps[1 - readIndex];
+            throw;
+        }
+        return result;
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if more than EPOCH_MAX_THREADS threads read at once
+     */
+    class TooManyThreads : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "too many reading threads";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty LeftRightHashMap
+     */
+    LeftRightHashMap() : _readIndex(0), _versionIndex(0), _slots(new ReadSlot[EPOCH_MAX_THREADS])
+    {
+        for (size_t i = 0; i < EPOCH_MAX_THREADS; i++)
+        {
+            _slots[i].readers[0].store(0, std::memory_order_relaxed);
+            _slots[i].readers[1].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * constructs a LeftRightHashMap holding the elements of a HashMap
+     * @param map - the HashMap
+     */
+    explicit LeftRightHashMap(const HashMap<KeyT, ValueT> &map) : LeftRightHashMap()
+    {
+        _maps[0] = map;
+        _maps[1] = map;
+    }
+
+    LeftRightHashMap(const LeftRightHashMap &other) = delete;
+
+    LeftRightHashMap &operator=(const LeftRightHashMap &other) = delete;
+
+    /**
+     * calls a function with the instance readers currently use. the instance is not changed
+     * before fn returns
+     * @param fn - called with a const HashMap<KeyT, ValueT> &
+     * @return what fn returned
+     */
+    template<typename Function>
+    auto read(Function fn) const -> decltype(fn(std::declval<const HashMap<KeyT, ValueT> &>()))
+    {
+        ReadSlot &slot = _ownSlot();
+        size_t version = _versionIndex.load(std::memory_order_seq_cst);
+        slot.readers[version].fetch_add(1, std::memory_order_seq_cst);
+        struct Depart
+        {
+            std::atomic<size_t> &readers;
+
+            ~Depart()
+            {
+                readers.fetch_sub(1, std::memory_order_release);
+            }
+        } depart{slot.readers[version]};
+        return fn(static_cast<const HashMap<KeyT, ValueT> &>(
+                          _maps[_readIndex.load(std::memory_order_seq_cst)]));
+    }
+
+    /**
+     * @return number of elements
+     */
+    size_t size() const noexcept(false)
+    {
+        return read([](const HashMap<KeyT, ValueT> &map)
+                    {
+                        return map.size();
+                    });
+    }
+
+    /**
+     * @return true if the map is empty
+     */
+    bool empty() const noexcept(false)
+    {
+        return size() == 0;
+    }
+
+    /**
+     * the function checks if a certain key is in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept(false)
+    {
+        return read([&key](const HashMap<KeyT, ValueT> &map)
+                    {
+                        return map.contains_key(key);
+                    });
+    }
+
+    /**
+     * the function gets a key and copies its value
+     * @param key - the key
+     * @param val - receives the value if the key is in the map
+     * @return true if the key is in the map
+     */
+    bool find(const KeyT &key, ValueT &val) const noexcept(false)
+    {
+        return read([&key, &val](const HashMap<KeyT, ValueT> &map)
+                    {
+                        auto it = map.find(key);
+                        if (it == map.end())
+                        {
+                            return false;
+                        }
+                        val = it->second;
+                        return true;
+                    });
+    }
+
+    /**
+     * the function gets a key and returns a copy of its value. in case the key is not in the map
+     * an exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT at(const KeyT &key) const noexcept(false)
+    {
+        return read([&key](const HashMap<KeyT, ValueT> &map)
+                    {
+                        return map.at(key);
+                    });
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _write([&key, &val](HashMap<KeyT, ValueT> &map)
+                      {
+                          return map.try_emplace(key, val).second;
+                      });
+    }
+
+    /**
+     * inserts a key with a value, or assigns the value if the key is already in the map
+     * @param key - the key
+     * @param val - the value
+     * @return true if the key was inserted
+     */
+    bool insert_or_assign(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _write([&key, &val](HashMap<KeyT, ValueT> &map)
+                      {
+                          return map.insert_or_assign(key, val).second;
+                      });
+    }
+
+    /**
+     * the function gets a key and erases its value
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _write([&key](HashMap<KeyT, ValueT> &map)
+                      {
+                          return map.erase(key);
+                      });
+    }
+
+    /**
+     * clears the map from all elements
+     */
+    void clear() noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        _write([](HashMap<KeyT, ValueT> &map)
+               {
+                   map.clear();
+                   return true;
+               });
+    }
+
+    /**
+     * applies a change to both instances, in the same way as insert and erase
+     * @param fn - called with a HashMap<KeyT, ValueT> & once per instance, must be deterministic
+     * @return what fn returned on the first instance
+     */
+    template<typename Function>
+    auto modify(Function fn) -> decltype(fn(std::declval<HashMap<KeyT, ValueT> &>()))
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _write(fn);
+    }
+};
+
+
+#endif //EX6_LEFTRIGHTHASHMAP_HPP
@@ -0,0 +1,489 @@
+#ifndef EX6_NODEPOOL_HPP
+#define EX6_NODEPOOL_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include "SpinLock.hpp"
+
+// -------------------------- const definitions -------------------------
+#define NODE_POOL_ALIGNMENT 16
+#define NODE_POOL_SIZE_CLASSES 16
+#define NODE_POOL_FIRST_CHUNK 4096
+#define NODE_POOL_MAX_CHUNK 65536
+
+// ------------------------------ functions -----------------------------
+/**
+ * a slab allocator of small blocks, such as the list nodes of a HashMap. a block of up to
+ * NODE_POOL_SIZE_CLASSES * NODE_POOL_ALIGNMENT bytes is rounded up to a multiple of
+ * NODE_POOL_ALIGNMENT, and every such size is carved from chunks of its own, which grow from
+ * NODE_POOL_FIRST_CHUNK to NODE_POOL_MAX_CHUNK bytes. a freed block is kept in a free list of its
+ * size and handed out before new chunk space, so a map under steady churn keeps a steady
+ * footprint. release gives back every chunk none of whose blocks is in use - a HashMap calls it
+ * when it is cleared or destroyed, so clearing or destroying a map frees the chunks only it used,
+ * and the destructor frees them in any case. bigger blocks come from the global allocator. a spinlock
+ * guards the pool, for the parallel operations of a map and maps of several threads sharing it -
+ * it is held for a few instructions, where a mutex would cost more than the allocation itself
+ */
+class NodePool
+{
+private:
+    /**
+     * a free block, linked in the free list of its size
+     */
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    /**
+     * the blocks of one size
+     */
+    struct SizeClass
+    {
+        /**
+         * freed blocks
+         */
+        FreeBlock *free;
+        /**
+         * the last chunk, and the part of it no block was carved from yet
+         */
+        char *current;
+        char *cursor;
+        char *limit;
+        /**
+         * size of the next chunk
+         */
+        size_t nextChunk;
+    };
+
+    /**
+     * a chunk blocks are carved from
+     */
+    struct Chunk
+    {
+        char *begin;
+        size_t size;
+        /**
+         * size of its blocks
+         */
+        size_t blockSize;
+        /**
+         * number of its blocks in the free lists, counted by release
+         */
+        size_t freeBlocks;
+    };
+
+    /**
+     * guards the pool
+     */
+    mutable SpinLock _lock;
+    /**
+     * the blocks of every size
+     */
+    SizeClass _classes[NODE_POOL_SIZE_CLASSES];
+    /**
+     * all chunks
+     */
+    std::vector<Chunk> _chunks;
+    /**
+     * number of blocks handed out and not freed yet
+     */
+    size_t _inUse;
+
+    /**
+     * @param size - size of a block, in (0, NODE_POOL_SIZE_CLASSES * NODE_POOL_ALIGNMENT]
+     * @return index of its size class
+     */
+    static size_t _classOf(size_t size) noexcept
+    {
+        return (size - 1) / NODE_POOL_ALIGNMENT;
+    }
+
+    /**
+     * @param size - size of a block
+     * @return true if it is carved from chunks
+     */
+    static bool _pooled(size_t size) noexcept
+    {
+        return size > 0 && size <= NODE_POOL_SIZE_CLASSES * NODE_POOL_ALIGNMENT;
+    }
+
+    /**
+     * frees all chunks and empties every size class
+     */
+    void _releaseChunks() noexcept
+    {
+        for (const Chunk &chunk : _chunks)
+        {
+            ::operator delete(chunk.begin);
+        }
+        _chunks.clear();
+        for (SizeClass &sizeClass : _classes)
+        {
+            sizeClass = {nullptr, nullptr, nullptr, nullptr, NODE_POOL_FIRST_CHUNK};
+        }
+    }
+
+    /**
+     * carves a block from the last chunk of a size class, or from a new chunk if it is used up
+     * @param sizeClass - the size class
+     * @param blockSize - size of its blocks
+     * @return the block
+     */
+    void *_carve(SizeClass &sizeClass, size_t blockSize) noexcept(false)
+    {
+        if ((size_t) (sizeClass.limit - sizeClass.cursor) < blockSize)
+        {
+            size_t chunkSize = sizeClass.nextChunk;
+            // reserved first, so a chunk is never left out of _chunks
+            _chunks.reserve(_chunks.size() + 1);
+            char *chunk = static_cast<char *>(::operator new(chunkSize));
+            _chunks.push_back({chunk, chunkSize, blockSize, 0});
+            sizeClass.current = chunk;
+            sizeClass.cursor = chunk;
+            sizeClass.limit = chunk + chunkSize;
+            sizeClass.nextChunk = chunkSize * 2 < NODE_POOL_MAX_CHUNK ? chunkSize * 2
+                                                                      : NODE_POOL_MAX_CHUNK;
+        }
+        void *block = sizeClass.cursor;
+        sizeClass.cursor += blockSize;
+        return block;
+    }
+
+    /**
+     * @param block - a block carved from a chunk, _chunks must be sorted by address
+     * @return the chunk of the block
+     */
+    Chunk &_chunkOf(const void *block) noexcept
+    {
+        auto after = std::upper_bound(_chunks.begin(), _chunks.end(),
+                                      static_cast<const char *>(block),
+                                      [](const char *address, const Chunk &chunk)
+                                      {
+                                          return std::less<const char *>()(address, chunk.begin);
+                                      });
+        return *(after - 1);
+    }
+
+    /**
+     * @param chunk - a chunk
+     * @return number of blocks carved from it so far
+     */
+    size_t _carved(const Chunk &chunk) const noexcept
+    {
+        const SizeClass &sizeClass = _classes[_classOf(chunk.blockSize)];
+        if (chunk.begin == sizeClass.current)
+        {
+            return (size_t) (sizeClass.cursor - chunk.begin) / chunk.blockSize;
+        }
+        return chunk.size / chunk.blockSize;
+    }
+
+    /**
+     * frees the chunks all of whose carved blocks are free, and drops their blocks from the free
+     * lists. walks every free list, so it takes time in the number of free blocks
+     * @return number of freed chunks
+     */
+    size_t _releaseFreeChunks() noexcept
+    {
+        std::sort(_chunks.begin(), _chunks.end(), [](const Chunk &first, const Chunk &second)
+        {
+            return std::less<const char *>()(first.begin, second.begin);
+        });
+        for (Chunk &chunk : _chunks)
+        {
+            chunk.freeBlocks = 0;
+        }
+        for (const SizeClass &sizeClass : _classes)
+        {
+            for (FreeBlock *block = sizeClass.free; block != nullptr; block = block->next)
+            {
+                _chunkOf(block).freeBlocks++;
+            }
+        }
+        // an unused chunk is marked by a free count past its capacity
+        size_t released = 0;
+        for (Chunk &chunk : _chunks)
+        {
+            if (chunk.freeBlocks == _carved(chunk))
+            {
+                chunk.freeBlocks = (size_t) -1;
+                released++;
+            }
+        }
+        if (released == 0)
+        {
+            return 0;
+        }
+        for (SizeClass &sizeClass : _classes)
+        {
+            FreeBlock **link = &sizeClass.free;
+            while (*link != nullptr)
+            {
+                if (_chunkOf(*link).freeBlocks == (size_t) -1)
+                {
+                    *link = (*link)->next;
+                }
+                else
+                {
+                    link = &(*link)->next;
+                }
+            }
+        }
+        for (Chunk &chunk : _chunks)
+        {
+            if (chunk.freeBlocks == (size_t) -1)
+            {
+                SizeClass &sizeClass = _classes[_classOf(chunk.blockSize)];
+                if (chunk.begin == sizeClass.current)
+                {
+                    sizeClass.current = nullptr;
+                    sizeClass.cursor = nullptr;
+                    sizeClass.limit = nullptr;
+                }
+                ::operator delete(chunk.begin);
+            }
+        }
+        _chunks.erase(std::remove_if(_chunks.begin(), _chunks.end(), [](const Chunk &chunk)
+        {
+            return chunk.freeBlocks == (size_t) -1;
+        }), _chunks.end());
+        return released;
+    }
+
+public:
+    /**
+     * constructs a pool without chunks
+     */
+    NodePool() : _inUse(0)
+    {
+        _releaseChunks();
+    }
+
+    NodePool(const NodePool &other) = delete;
+
+    NodePool &operator=(const NodePool &other) = delete;
+
+    /**
+     * frees all chunks, no block may be in use
+     */
+    ~NodePool()
+    {
+        _releaseChunks();
+    }
+
+    /**
+     * @param size - size of the block in bytes
+     * @return a block aligned to NODE_POOL_ALIGNMENT
+     */
+    void *allocate(size_t size) noexcept(false)
+    {
+        if (!_pooled(size))
+        {
+            return ::operator new(size);
+        }
+        std::lock_guard<SpinLock> guard(_lock);
+        SizeClass &sizeClass = _classes[_classOf(size)];
+        void *block;
+        if (sizeClass.free != nullptr)
+        {
+            block = sizeClass.free;
+            sizeClass.free = sizeClass.free->next;
+        }
+        else
+        {
+            block = _carve(sizeClass, (_classOf(size) + 1) * NODE_POOL_ALIGNMENT);
+        }
+        _inUse++;
+        return block;
+    }
+
+    /**
+     * gives a block back to the free list of its size
+     * @param block - a block allocate returned
+     * @param size - the size it was allocated with
+     */
+    void deallocate(void *block, size_t size) noexcept
+    {
+        if (!_pooled(size))
+        {
+            ::operator delete(block);
+            return;
+        }
+        std::lock_guard<SpinLock> guard(_lock);
+        SizeClass &sizeClass = _classes[_classOf(size)];
+        FreeBlock *freed = static_cast<FreeBlock *>(block);
+        freed->next = sizeClass.free;
+        sizeClass.free = freed;
+        _inUse--;
+    }
+
+    /**
+     * frees every chunk none of whose blocks is in use - all of them if no block is in use. the
+     * pool stays usable and carves new chunks
+     * @return number of freed chunks
+     */
+    size_t release() noexcept
+    {
+        std::lock_guard<SpinLock> guard(_lock);
+        if (_inUse == 0)
+        {
+            size_t released = _chunks.size();
+            _releaseChunks();
+            return released;
+        }
+        return _releaseFreeChunks();
+    }
+
+    /**
+     * @return number of blocks carved from chunks that are in use
+     */
+    size_t in_use() const noexcept
+    {
+        std::lock_guard<SpinLock> guard(_lock);
+        return _inUse;
+    }
+
+    /**
+     * @return number of chunks held
+     */
+    size_t chunks() const noexcept
+    {
+        std::lock_guard<SpinLock> guard(_lock);
+        return _chunks.size();
+    }
+};
+
+/**
+ * allocator of a HashMap whose list nodes come from a NodePool. the allocator only points to the
+ * pool, which must outlive every map using it - every bucket of a map holds a copy of the
+ * allocator, so a pointer keeps the buckets small and their copies cheap. a copy of a map uses the
+ * same pool, and the pool moves and swaps along with the nodes of a map. a type aligned to more
+ * than NODE_POOL_ALIGNMENT comes from std::allocator
+ * @tparam T - the allocated type
+ */
+template<typename T>
+class NodePoolAllocator
+{
+private:
+    template<typename U>
+    friend class NodePoolAllocator;
+
+    /**
+     * the pool
+     */
+    NodePool *_pool;
+
+    /**
+     * true if T is carved from the pool
+     */
+    typedef std::integral_constant<bool, alignof(T) <= NODE_POOL_ALIGNMENT> Pooled;
+
+    /**
+     * @param n - number of objects
+     * @return room for n objects, from the pool
+     */
+    T *_allocate(size_t n, std::true_type) noexcept(false)
+    {
+        if (n > (size_t) -1 / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(_pool->allocate(n * sizeof(T)));
+    }
+
+    /**
+     * @param n - number of objects
+     * @return room for n over-aligned objects, from std::allocator
+     */
+    T *_allocate(size_t n, std::false_type) noexcept(false)
+    {
+        return std::allocator<T>().allocate(n);
+    }
+
+    /**
+     * gives room back to the pool
+     * @param p - the room
+     * @param n - the number of objects it was allocated for
+     */
+    void _deallocate(T *p, size_t n, std::true_type) noexcept
+    {
+        _pool->deallocate(p, n * sizeof(T));
+    }
+
+    /**
+     * gives room back to std::allocator
+     * @param p - the room
+     * @param n - the number of objects it was allocated for
+     */
+    void _deallocate(T *p, size_t n, std::false_type) noexcept
+    {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    /**
+     * constructs an allocator of a pool
+     * @param pool - the pool
+     */
+    explicit NodePoolAllocator(NodePool &pool) noexcept : _pool(&pool)
+    {}
+
+    template<typename U>
+    NodePoolAllocator(const NodePoolAllocator<U> &other) noexcept : _pool(other._pool)
+    {}
+
+    /**
+     * @param n - number of objects
+     * @return room for n objects
+     */
+    T *allocate(size_t n) noexcept(false)
+    {
+        return _allocate(n, Pooled{});
+    }
+
+    /**
+     * @param p - room allocate returned
+     * @param n - the number of objects it was allocated for
+     */
+    void deallocate(T *p, size_t n) noexcept
+    {
+        _deallocate(p, n, Pooled{});
+    }
+
+    /**
+     * @return the pool
+     */
+    NodePool &pool() const noexcept
+    {
+        return *_pool;
+    }
+
+    template<typename U>
+    bool operator==(const NodePoolAllocator<U> &other) const noexcept
+    {
+        return _pool == other._pool;
+    }
+
+    template<typename U>
+    bool operator!=(const NodePoolAllocator<U> &other) const noexcept
+    {
+        return _pool != other._pool;
+    }
+};
+
+
+#endif //EX6_NODEPOOL_HPP
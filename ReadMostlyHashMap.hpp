@@ -0,0 +1,400 @@
+#ifndef EX6_READMOSTLYHASHMAP_HPP
+#define EX6_READMOSTLYHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <stdexcept>
+#include "HashMix.hpp"
+#include "Epoch.hpp"
+
+// -------------------------- const definitions -------------------------
+#define READ_MOSTLY_DEFAULT_CAPACITY 16
+#define READ_MOSTLY_LOAD_FACTOR 0.75
+
+// ------------------------------ functions -----------------------------
+/**
+ * concurrent HashMap containing KeyT and ValueT, for maps that are read far more than written.
+ * readers never lock: they pin an epoch and walk chains of immutable nodes. writers serialize on a
+ * mutex, publish new nodes and bucket arrays with a single atomic store, and retire what they
+ * unlinked to the epoch domain, which frees it once no reader can still see it. assigning a value
+ * replaces its node, and a resize builds a new bucket array, so a reader always sees either the
+ * old or the new state
+ */
+template<typename KeyT, typename ValueT>
+class ReadMostlyHashMap
+{
+private:
+    /**
+     * an element, never changed after it is published except for its link
+     */
+    struct Node
+    {
+        std::pair<KeyT, ValueT> item;
+        std::atomic<Node *> next;
+
+        Node(const KeyT &key, const ValueT &val, Node *nextNode) : item(key, val), next(nextNode)
+        {
+        }
+    };
+
+    /**
+     * a bucket array together with the nodes linked into it
+     */
+    struct Table
+    {
+        size_t capacity;
+        std::unique_ptr<std::atomic<Node *>[]> heads;
+
+        explicit Table(size_t cap) : capacity(cap), heads(new std::atomic<Node *>[cap])
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                heads[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~Table()
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                Node *node = heads[i].load(std::memory_order_relaxed);
+                while (node != nullptr)
+                {
+                    Node *next = node->next.load(std::memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+    };
+
+    /**
+     * the published table
+     */
+    std::atomic<Table *> _table;
+    /**
+     * number of elements, only written by writers
+     */
+    std::atomic<size_t> _size;
+    /**
+     * serializes the writers
+     */
+    std::mutex _writeLock;
+    /**
+     * reclaims unlinked nodes and tables
+     */
+    mutable EpochDomain _epochs;
+
+    /**
+     * @param table - a table
+     * @param key - a key
+     * @return the head of the key's bucket in the table
+     */
+    static std::atomic<Node *> &_headOf(const Table *table, const KeyT &key) noexcept
+    {
+        return table->heads[mixHash(std::hash<KeyT>{}(key)) & (table->capacity - 1)];
+    }
+
+    /**
+     * finds the node of a key, the caller must be pinned or hold the write lock
+     * @param key - the key
+     * @return the node, or nullptr if the key is not in the map
+     */
+    const Node *_findNode(const KeyT &key) const noexcept
+    {
+        const Table *table = _table.load(std::memory_order_acquire);
+        Node *node = _headOf(table, key).load(std::memory_order_acquire);
+        while (node != nullptr && !(node->item.first == key))
+        {
+            node = node->next.load(std::memory_order_acquire);
+        }
+        return node;
+    }
+
+    /**
+     * finds the link pointing at the node of a key, the write lock must be held
+     * @param key - the key
+     * @return the link, which holds nullptr if the key is not in the map
+     */
+    std::atomic<Node *> *_findLink(const KeyT &key) noexcept
+    {
+        std::atomic<Node *> *link = &_headOf(_table.load(std::memory_order_relaxed), key);
+        Node *node = link->load(std::memory_order_relaxed);
+        while (node != nullptr && !(node->item.first == key))
+        {
+            link = &node->next;
+            node = link->load(std::memory_order_relaxed);
+        }
+        return link;
+    }
+
+    /**
+     * publishes a copy of the map in a table of a new capacity and retires the old table, the
+     * write lock must be held
+     * @param newCapacity - capacity of the new table
+     */
+    void _rebuild(size_t newCapacity) noexcept(false)
+    {
+        Table *oldTable = _table.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> newTable(new Table(newCapacity));
+        for (size_t i = 0; i < oldTable->capacity; i++)
+        {
+            Node *node = oldTable->heads[i].load(std::memory_order_relaxed);
+            for (; node != nullptr; node = node->next.load(std::memory_order_relaxed))
+            {
+                std::atomic<Node *> &head = _headOf(newTable.get(), node->item.first);
+                head.store(new Node(node->item.first, node->item.second,
+                                    head.load(std::memory_order_relaxed)),
+                           std::memory_order_relaxed);
+            }
+        }
+        _table.store(newTable.release(), std::memory_order_release);
+        _epochs.retire(oldTable);
+    }
+
+    /**
+     * links a new node at the head of its bucket, growing the table first if needed. the write
+     * lock must be held
+     * @param key - the key
+     * @param val - the value
+     */
+    void _link(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        size_t cap = capacity();
+        if (size() + 1 > cap * READ_MOSTLY_LOAD_FACTOR)
+        {
+            _rebuild(cap * 2);
+        }
+        std::atomic<Node *> &head = _headOf(_table.load(std::memory_order_relaxed), key);
+        head.store(new Node(key, val, head.load(std::memory_order_relaxed)),
+                   std::memory_order_release);
+        _size.store(size() + 1, std::memory_order_relaxed);
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the ReadMostlyHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty ReadMostlyHashMap
+     */
+    ReadMostlyHashMap() : _table(new Table(READ_MOSTLY_DEFAULT_CAPACITY)), _size(0)
+    {
+    }
+
+    ReadMostlyHashMap(const ReadMostlyHashMap &other) = delete;
+
+    ReadMostlyHashMap &operator=(const ReadMostlyHashMap &other) = delete;
+
+    /**
+     * destructor, no other thread may use the map
+     */
+    ~ReadMostlyHashMap()
+    {
+        delete _table.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return number of elements
+     */
+    size_t size() const noexcept
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return capacity of the published table
+     */
+    size_t capacity() const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        return _table.load(std::memory_order_acquire)->capacity;
+    }
+
+    /**
+     * @return true if the map is empty
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * the function checks if a certain key is in the map, without locking
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        return _findNode(key) != nullptr;
+    }
+
+    /**
+     * the function gets a key and copies its value, without locking
+     * @param key - the key
+     * @param val - receives the value if the key is in the map
+     * @return true if the key is in the map
+     */
+    bool find(const KeyT &key, ValueT &val) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        const Node *node = _findNode(key);
+        if (node == nullptr)
+        {
+            return false;
+        }
+        val = node->item.second;
+        return true;
+    }
+
+    /**
+     * the function gets a key and returns a copy of its value, without locking. in case the key
+     * is not in the map an exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT at(const KeyT &key) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        const Node *node = _findNode(key);
+        if (node == nullptr)
+        {
+            throw KeyNotFound{};
+        }
+        return node->item.second;
+    }
+
+    /**
+     * calls a function with every element of the published table, without locking
+     * @param fn - called with a const std::pair<KeyT, ValueT> &
+     */
+    template<typename Function>
+    void for_each(Function fn) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        const Table *table = _table.load(std::memory_order_acquire);
+        for (size_t i = 0; i < table->capacity; i++)
+        {
+            Node *node = table->heads[i].load(std::memory_order_acquire);
+            for (; node != nullptr; node = node->next.load(std::memory_order_acquire))
+            {
+                fn(static_cast<const std::pair<KeyT, ValueT> &>(node->item));
+            }
+        }
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        if (_findLink(key)->load(std::memory_order_relaxed) != nullptr)
+        {
+            return false;
+        }
+        _link(key, val);
+        _epochs.reclaim();
+        return true;
+    }
+
+    /**
+     * inserts a key with a value, or replaces the node of the key with one holding the value
+     * @param key - the key
+     * @param val - the value
+     * @return true if the key was inserted
+     */
+    bool insert_or_assign(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        std::atomic<Node *> *link = _findLink(key);
+        Node *old = link->load(std::memory_order_relaxed);
+        if (old == nullptr)
+        {
+            _link(key, val);
+            _epochs.reclaim();
+            return true;
+        }
+        link->store(new Node(key, val, old->next.load(std::memory_order_relaxed)),
+                    std::memory_order_release);
+        _epochs.retire(old);
+        _epochs.reclaim();
+        return false;
+    }
+
+    /**
+     * the function gets a key and erases its value
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        std::atomic<Node *> *link = _findLink(key);
+        Node *old = link->load(std::memory_order_relaxed);
+        if (old == nullptr)
+        {
+            return false;
+        }
+        link->store(old->next.load(std::memory_order_relaxed), std::memory_order_release);
+        _size.store(size() - 1, std::memory_order_relaxed);
+        _epochs.retire(old);
+        _epochs.reclaim();
+        return true;
+    }
+
+    /**
+     * makes room for a number of elements, so inserting them does not resize
+     * @param elements - number of elements
+     */
+    void reserve(size_t elements) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        size_t cap = capacity();
+        size_t newCapacity = cap;
+        while (elements > newCapacity * READ_MOSTLY_LOAD_FACTOR)
+        {
+            newCapacity *= 2;
+        }
+        if (newCapacity != cap)
+        {
+            _rebuild(newCapacity);
+            _epochs.reclaim();
+        }
+    }
+
+    /**
+     * clears the map from all elements by publishing an empty table
+     */
+    void clear() noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        Table *oldTable = _table.load(std::memory_order_relaxed);
+        _table.store(new Table(READ_MOSTLY_DEFAULT_CAPACITY), std::memory_order_release);
+        _size.store(0, std::memory_order_relaxed);
+        _epochs.retire(oldTable);
+        _epochs.reclaim();
+    }
+};
+
+
+#endif //EX6_READMOSTLYHASHMAP_HPP
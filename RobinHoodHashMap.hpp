@@ -0,0 +1,713 @@
+#ifndef EX6_ROBINHOODHASHMAP_HPP
+#define EX6_ROBINHOODHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <memory>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
+#include "HashMix.hpp"
+
+// -------------------------- const definitions -------------------------
+#define ROBIN_HOOD_DEFAULT_CAPACITY 16
+#define ROBIN_HOOD_DEFAULT_LOAD_FACTOR 0.9
+#define ROBIN_HOOD_MAX_LOAD_FACTOR 0.97
+#define ROBIN_HOOD_MAX_DISTANCE 254
+
+// ------------------------------ functions -----------------------------
+/**
+ * open addressing HashMap containing KeyT and ValueT that uses Robin Hood linear probing: an
+ * inserted pair takes the slot of any pair that is closer to its own home slot. every slot keeps
+ * its probe distance, so a lookup of a missing key stops as soon as it meets a pair closer to home
+ * than itself, and erase shifts the following pairs back instead of leaving tombstones. this keeps
+ * probe sequences short at load factors of 0.9 and above. exposes the same interface as HashMap
+ */
+template<typename KeyT, typename ValueT>
+class RobinHoodHashMap
+{
+public:
+    typedef std::pair<KeyT, ValueT> value_type;
+
+private:
+    /**
+     * number of slots - a power of two
+     */
+    size_t _capacity;
+    /**
+     * number of pairs in the map
+     */
+    size_t _size;
+    /**
+     * load factor the table grows at
+     */
+    double _maxLoadFactor;
+    /**
+     * probe distance of every slot plus one, 0 marks an empty slot
+     */
+    uint8_t *_dist;
+    /**
+     * the slots, only the ones with a non zero distance hold a constructed pair
+     */
+    value_type *_slots;
+
+    /**
+     * @param key - the key
+     * @return home slot of the key
+     */
+    size_t _home(const KeyT &key) const noexcept
+    {
+        return mixHash(std::hash<KeyT>{}(key)) & (_capacity - 1);
+    }
+
+    /**
+     * @param idx - slot index
+     * @return the slot after idx, wrapping around the end of the table
+     */
+    size_t _next(size_t idx) const noexcept
+    {
+        return (idx + 1) & (_capacity - 1);
+    }
+
+    /**
+     * allocates an empty table
+     * @param capacity - number of slots
+     */
+    void _allocate(size_t capacity) noexcept(false)
+    {
+        _slots = std::allocator<value_type>().allocate(capacity);
+        try
+        {
+            _dist = new uint8_t[capacity];
+        }
+        catch (...)
+        {
+            std::allocator<value_type>().deallocate(_slots, capacity);
+            throw;
+        }
+        std::memset(_dist, 0, capacity);
+        _capacity = capacity;
+    }
+
+    /**
+     * destroys all pairs and frees the table
+     */
+    void _release() noexcept
+    {
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_dist[i])
+            {
+                _slots[i].~value_type();
+            }
+        }
+        delete[] _dist;
+        std::allocator<value_type>().deallocate(_slots, _capacity);
+    }
+
+    /**
+     * @param key - the key we are looking for
+     * @return slot index of the key, or capacity() if the key is not in the map
+     */
+    size_t _find(const KeyT &key) const noexcept
+    {
+        size_t idx = _home(key);
+        for (unsigned dist = 1; dist <= _dist[idx]; dist++)
+        {
+            // only a pair at the same distance shares our home slot
+            if (_dist[idx] == dist && _slots[idx].first == key)
+            {
+                return idx;
+            }
+            idx = _next(idx);
+        }
+        return _capacity;
+    }
+
+    /**
+     * places a pair whose key is not in the map, displacing richer pairs on the way
+     * @param val - the pair to place, it is left moved from
+     * @return slot index of the placed pair
+     */
+    size_t _place(value_type &&val) noexcept(false)
+    {
+        size_t idx = _home(val.first);
+        size_t placedAt = _capacity;
+        unsigned dist = 1;
+        value_type carried(std::move(val));
+        while (_dist[idx])
+        {
+            if (_dist[idx] < dist)
+            {
+                std::swap(carried, _slots[idx]);
+                unsigned carriedDist = _dist[idx];
+                _dist[idx] = (uint8_t) dist;
+                dist = carriedDist;
+                if (placedAt == _capacity)
+                {
+                    placedAt = idx;
+                }
+            }
+            idx = _next(idx);
+            if (++dist > ROBIN_HOOD_MAX_DISTANCE)
+            {
+                // too long a cluster - grow and place whatever pair is still carried
+                if (placedAt == _capacity)
+                {
+                    _rehash(_capacity * 2);
+                    return _place(std::move(carried));
+                }
+                KeyT placedKey = _slots[placedAt].first;
+                _rehash(_capacity * 2);
+                _place(std::move(carried));
+                return _find(placedKey);
+            }
+        }
+        ::new((void *) (_slots + idx)) value_type(std::move(carried));
+        _dist[idx] = (uint8_t) dist;
+        return placedAt == _capacity ? idx : placedAt;
+    }
+
+    /**
+     * moves all pairs to a new table
+     * @param newCapacity - the capacity after resizing
+     */
+    void _rehash(size_t newCapacity) noexcept(false)
+    {
+        uint8_t *oldDist = _dist;
+        value_type *oldSlots = _slots;
+        size_t oldCapacity = _capacity;
+        _allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldDist[i])
+            {
+                _place(std::move(oldSlots[i]));
+                oldSlots[i].~value_type();
+            }
+        }
+        delete[] oldDist;
+        std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+    }
+
+    /**
+     * inserts a pair whose key is not in the map, growing the table if needed
+     * @param val - the pair to insert
+     * @return slot index of the inserted pair
+     */
+    size_t _insertNew(value_type &&val) noexcept(false)
+    {
+        if (_size + 1 > _capacity * _maxLoadFactor)
+        {
+            _rehash(_capacity * 2);
+        }
+        size_t idx = _place(std::move(val));
+        _size++;
+        return idx;
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the RobinHoodHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+    /**
+     * exception thrown if given vectors do not have the same size
+     */
+    class VectorsLength : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "the vectors do not have same size";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty RobinHoodHashMap
+     * @param maxLoadFactor - load factor the table grows at, up to ROBIN_HOOD_MAX_LOAD_FACTOR
+     */
+    explicit RobinHoodHashMap(double maxLoadFactor = ROBIN_HOOD_DEFAULT_LOAD_FACTOR) :
+            _capacity(0), _size(0), _maxLoadFactor(ROBIN_HOOD_DEFAULT_LOAD_FACTOR),
+            _dist(nullptr), _slots(nullptr)
+    {
+        _allocate(ROBIN_HOOD_DEFAULT_CAPACITY);
+        max_load_factor(maxLoadFactor);
+    }
+
+    /**
+     * a constructor that gets an iterator for keys and iterator for values and constructs a
+     * RobinHoodHashMap with matching pairs, a repeated key keeps its last value
+     * @tparam KeysInputIterator - type of keys iterator
+     * @tparam ValuesInputIterator - type of values iterator
+     * @param keysBegin - beginning of keys iterator
+     * @param keysEnd - end of keys iterator
+     * @param valuesBegin - beginning of values iterator
+     * @param valuesEnd - end of values iterator
+     */
+    template<typename KeysInputIterator, typename ValuesInputIterator>
+    RobinHoodHashMap(const KeysInputIterator keysBegin, const KeysInputIterator keysEnd,
+                     const ValuesInputIterator valuesBegin, const ValuesInputIterator valuesEnd) :
+            RobinHoodHashMap()
+    {
+        if (std::distance(keysBegin, keysEnd) - std::distance(valuesBegin, valuesEnd))
+        {
+            throw VectorsLength{};
+        }
+        auto it2 = valuesBegin;
+        for (auto it1 = keysBegin; it1 != keysEnd; it1++, it2++)
+        {
+            if (!insert(*it1, *it2))
+            {
+                at(*it1) = *it2;
+            }
+        }
+    }
+
+    /**
+     * copy constructor
+     * @param other - RobinHoodHashMap to copy from
+     */
+    RobinHoodHashMap(const RobinHoodHashMap &other) :
+            _capacity(0), _size(0), _maxLoadFactor(other._maxLoadFactor), _dist(nullptr),
+            _slots(nullptr)
+    {
+        _allocate(other._capacity);
+        for (size_t i = 0; i < other._capacity; i++)
+        {
+            if (other._dist[i])
+            {
+                try
+                {
+                    ::new((void *) (_slots + i)) value_type(other._slots[i]);
+                }
+                catch (...)
+                {
+                    _release();
+                    throw;
+                }
+                _dist[i] = other._dist[i];
+            }
+        }
+        _size = other._size;
+    }
+
+    /**
+     * RobinHoodHashMap destructor
+     */
+    ~RobinHoodHashMap()
+    {
+        _release();
+    }
+
+    /**
+     * @return size of the map
+     */
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * @return current capacity of the map
+     */
+    size_t capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    /**
+     * @return true if map is empty
+     */
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /**
+     * @return current load factor
+     */
+    double load_factor() const noexcept
+    {
+        return (double) size() / capacity();
+    }
+
+    /**
+     * @return load factor the table grows at
+     */
+    double max_load_factor() const noexcept
+    {
+        return _maxLoadFactor;
+    }
+
+    /**
+     * sets the load factor the table grows at, growing the table right away if it is already
+     * above it
+     * @param maxLoadFactor - new maximal load factor, clamped to ROBIN_HOOD_MAX_LOAD_FACTOR
+     */
+    void max_load_factor(double maxLoadFactor) noexcept(false)
+    {
+        if (!(maxLoadFactor > 0))
+        {
+            maxLoadFactor = ROBIN_HOOD_DEFAULT_LOAD_FACTOR;
+        }
+        _maxLoadFactor = maxLoadFactor < ROBIN_HOOD_MAX_LOAD_FACTOR ? maxLoadFactor
+                                                                   : ROBIN_HOOD_MAX_LOAD_FACTOR;
+        size_t newCapacity = _capacity;
+        while (_size > newCapacity * _maxLoadFactor)
+        {
+            newCapacity *= 2;
+        }
+        if (newCapacity != _capacity)
+        {
+            _rehash(newCapacity);
+        }
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        if (_find(key) != _capacity)
+        {
+            return false;
+        }
+        _insertNew(value_type(key, val));
+        return true;
+    }
+
+    /**
+     * the function checks if a certain key is already in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept
+    {
+        return _find(key) != _capacity;
+    }
+
+    /**
+     * const version of the function - the function gets a key and returns its value. in case the
+     * key is not in the map an exception is thrown.
+     * @param key - the key
+     * @return - key's value
+     */
+    const ValueT &at(const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key);
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * the function gets a key and returns its value. in case the key is not in the map an
+     * exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT &at(const KeyT &key) noexcept(false)
+    {
+        size_t idx = _find(key);
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * the function gets a key and erases its value. the pairs after it that are not in their home
+     * slot are shifted one slot back, so no tombstone is left behind
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept
+    {
+        size_t idx = _find(key);
+        if (idx == _capacity)
+        {
+            return false;
+        }
+        _slots[idx].~value_type();
+        for (size_t next = _next(idx); _dist[next] > 1; idx = next, next = _next(next))
+        {
+            ::new((void *) (_slots + idx)) value_type(std::move(_slots[next]));
+            _slots[next].~value_type();
+            _dist[idx] = (uint8_t) (_dist[next] - 1);
+        }
+        _dist[idx] = 0;
+        _size--;
+        return true;
+    }
+
+    /**
+     * the function gets a key and returns it's bucket size - a slot holds a single pair. the
+     * function throws an exception if the key was not found
+     * @param key - the key
+     * @return - size of bucket
+     */
+    size_t bucket_size(const KeyT &key) const noexcept(false)
+    {
+        bucket_index(key);
+        return 1;
+    }
+
+    /**
+     * the function gets a key and returns the index of its slot if the map contains the key, or
+     * throws an exception if not
+     * @param key - the key
+     * @return - slot index
+     */
+    size_t bucket_index(const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key);
+        if (idx == _capacity)
+        {
+            throw KeyNotFound{};
+        }
+        return idx;
+    }
+
+    /**
+     * the function clears the map from all elements, the capacity is kept
+     */
+    void clear() noexcept
+    {
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_dist[i])
+            {
+                _slots[i].~value_type();
+            }
+        }
+        std::memset(_dist, 0, _capacity);
+        _size = 0;
+    }
+
+    /**
+     * assignment operator
+     * @param other - map to copy elements from
+     * @return reference to RobinHoodHashMap
+     */
+    RobinHoodHashMap &operator=(const RobinHoodHashMap &other) noexcept(false)
+    {
+        if (this != &other)
+        {
+            RobinHoodHashMap copy(other);
+            std::swap(_capacity, copy._capacity);
+            std::swap(_size, copy._size);
+            std::swap(_maxLoadFactor, copy._maxLoadFactor);
+            std::swap(_dist, copy._dist);
+            std::swap(_slots, copy._slots);
+        }
+        return *this;
+    }
+
+    /**
+     * subscript operator, inserts a default value if the key is not in the map
+     * @param key - the key
+     * @return reference to the key's value
+     */
+    ValueT &operator[](const KeyT &key) noexcept(false)
+    {
+        size_t idx = _find(key);
+        if (idx == _capacity)
+        {
+            idx = _insertNew(value_type(key, ValueT()));
+        }
+        return _slots[idx].second;
+    }
+
+    /**
+     * subscript operator
+     * @param key - the key
+     * @return the key's value, or a default value if the key is not in the map
+     */
+    ValueT operator[](const KeyT &key) const noexcept(false)
+    {
+        size_t idx = _find(key);
+        return idx == _capacity ? ValueT() : _slots[idx].second;
+    }
+
+    /**
+     * checks if two maps are identical
+     * @param other - another map
+     * @return true if they are
+     */
+    bool operator==(const RobinHoodHashMap &other) const noexcept
+    {
+        if (this->capacity() != other.capacity() || this->size() != other.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < _capacity; i++)
+        {
+            if (_dist[i])
+            {
+                size_t idx = other._find(_slots[i].first);
+                if (idx == other._capacity || !(other._slots[idx].second == _slots[i].second))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * checks if two maps are not identical
+     * @param other - another map
+     * @return true if they are different
+     */
+    bool operator!=(const RobinHoodHashMap &other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+// -------------------------- iterator class -------------------------
+
+    /**
+     * class of a const iterator for RobinHoodHashMap
+     */
+    class ConstIterator
+    {
+        const RobinHoodHashMap *_map;
+        size_t _index;
+
+        /**
+         * moves forward to the first full slot at or after the current one
+         */
+        void _skipEmpty() noexcept
+        {
+            while (_index < _map->_capacity && !_map->_dist[_index])
+            {
+                _index++;
+            }
+        }
+
+    public:
+        /**
+         * iterator traits:
+         */
+        typedef std::pair<KeyT, ValueT> value_type;
+        typedef const std::pair<KeyT, ValueT> *pointer;
+        typedef const std::pair<KeyT, ValueT> &reference;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::forward_iterator_tag iterator_category;
+
+        ConstIterator() : _map(nullptr), _index(0)
+        {}
+
+        /**
+         * const iterator constructor
+         * @param map - the iterated map
+         * @param index - slot to start from, the iterator moves to the first full slot from it
+         */
+        ConstIterator(const RobinHoodHashMap *map, size_t index) : _map(map), _index(index)
+        {
+            _skipEmpty();
+        }
+
+        /**
+         * @return the element pointed to by the iterator
+         */
+        reference operator*() const
+        {
+            return _map->_slots[_index];
+        }
+
+        /**
+         * @return pointer to the element pointed to by the iterator
+         */
+        pointer operator->() const
+        {
+            return _map->_slots + _index;
+        }
+
+        /**
+         * prefix increment operator
+         * @return
+         */
+        ConstIterator &operator++()
+        {
+            _index++;
+            _skipEmpty();
+            return *this;
+        }
+
+        /**
+         * postfix increment operator
+         * @return
+         */
+        ConstIterator operator++(int)
+        {
+            ConstIterator tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        /**
+         * equal operator
+         * @param other - other iterator
+         * @return true if iterators are the same
+         */
+        bool operator==(const ConstIterator &other) const
+        {
+            return this->_map == other._map && this->_index == other._index;
+        }
+
+        /**
+         * not equal operator
+         * @param other - other iterator
+         * @return true if iterators are not the same
+         */
+        bool operator!=(const ConstIterator &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    typedef ConstIterator const_iterator;
+    typedef ConstIterator iterator;
+
+    const_iterator begin() const
+    {
+        return ConstIterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return ConstIterator(this, _capacity);
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+};
+
+
+#endif //EX6_ROBINHOODHASHMAP_HPP
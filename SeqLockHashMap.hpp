@@ -0,0 +1,668 @@
+#ifndef EX6_SEQLOCKHASHMAP_HPP
+#define EX6_SEQLOCKHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include "HashMix.hpp"
+#include "ConcurrentHashMap.hpp"
+#include "SpinLock.hpp"
+
+// -------------------------- const definitions -------------------------
+#define SEQLOCK_GROUP_SIZE 8
+#define SEQLOCK_DEFAULT_CAPACITY 16
+#define SEQLOCK_MAX_LOAD_NUMERATOR 3
+#define SEQLOCK_MAX_LOAD_DENOMINATOR 4
+#define SEQLOCK_MAX_ELEMENT_SIZE 32
+#define SEQLOCK_SLOT_EMPTY 0
+#define SEQLOCK_SLOT_FULL 1
+
+// ------------------------------ functions -----------------------------
+/**
+ * concurrent open addressing HashMap for small trivially copyable KeyT and ValueT. readers take no
+ * lock and write nothing: they copy the slots of a group of SEQLOCK_GROUP_SIZE slots, and retry if
+ * the group's sequence counter changed meanwhile. writers are serialized by a spinlock and make
+ * the counter of a group odd while they change it. an erase shifts the following elements back
+ * (linear probing, no tombstones), which can move an element to a group a reader already passed,
+ * so erases and clears also advance a map wide sequence counter. a grown table is published with
+ * one atomic store, and the old tables are kept until the map is destroyed, since a reader may
+ * still be copying from them - they add up to less than the current table
+ */
+template<typename KeyT, typename ValueT>
+class SeqLockHashMap
+{
+    static_assert(std::is_trivially_copyable<KeyT>::value &&
+                  std::is_trivially_copyable<ValueT>::value,
+                  "SeqLockHashMap needs trivially copyable keys and values");
+
+private:
+    enum : size_t
+    {
+        KEY_WORDS = (sizeof(KeyT) + sizeof(uint64_t) - 1) / sizeof(uint64_t),
+        VALUE_WORDS = (sizeof(ValueT) + sizeof(uint64_t) - 1) / sizeof(uint64_t)
+    };
+
+    /**
+     * a slot - its state, key and value, stored in atomic words so copying a slot that is being
+     * written is not a data race
+     */
+    struct Slot
+    {
+        std::atomic<uint64_t> state;
+        std::atomic<uint64_t> key[KEY_WORDS];
+        std::atomic<uint64_t> value[VALUE_WORDS];
+    };
+
+    /**
+     * slots sharing a sequence counter, which is odd while a writer changes one of them
+     */
+    struct Group
+    {
+        std::atomic<uint64_t> seq;
+        Slot slots[SEQLOCK_GROUP_SIZE];
+    };
+
+    /**
+     * a table of slots
+     */
+    struct Table
+    {
+        size_t capacity;
+        std::unique_ptr<Group[]> groups;
+
+        explicit Table(size_t cap) : capacity(cap), groups(new Group[cap / SEQLOCK_GROUP_SIZE])
+        {
+            for (size_t g = 0; g < capacity / SEQLOCK_GROUP_SIZE; g++)
+            {
+                groups[g].seq.store(0, std::memory_order_relaxed);
+                for (size_t s = 0; s < SEQLOCK_GROUP_SIZE; s++)
+                {
+                    groups[g].slots[s].state.store(SEQLOCK_SLOT_EMPTY, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @param idx - index of a slot
+         * @return the slot
+         */
+        Slot &slot(size_t idx) const noexcept
+        {
+            return groups[idx / SEQLOCK_GROUP_SIZE].slots[idx % SEQLOCK_GROUP_SIZE];
+        }
+    };
+
+    /**
+     * outcome of probing one table
+     */
+    enum ProbeResult
+    {
+        PROBE_ABSENT, PROBE_FOUND, PROBE_RETRY
+    };
+
+    /**
+     * the published table
+     */
+    std::atomic<Table *> _table;
+    /**
+     * tables replaced by a grown one, kept for readers still copying from them
+     */
+    std::vector<std::unique_ptr<Table>> _retired;
+    /**
+     * number of elements
+     */
+    std::atomic<size_t> _size;
+    /**
+     * odd while an erase or a clear moves elements
+     */
+    std::atomic<uint64_t> _shiftSeq;
+    /**
+     * serializes the writers
+     */
+    SpinLock _writeLock;
+
+    /**
+     * @param key - a key
+     * @return the mixed hash of the key
+     */
+    static size_t _hashCode(const KeyT &key) noexcept
+    {
+        return mixHash(std::hash<KeyT>{}(key));
+    }
+
+    /**
+     * copies an object out of atomic words
+     * @param words - the words
+     * @return the object
+     */
+    template<typename T>
+    static T _unpack(const std::atomic<uint64_t> *words) noexcept
+    {
+        uint64_t buffer[(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+        for (size_t i = 0; i < sizeof(buffer) / sizeof(uint64_t); i++)
+        {
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        }
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        std::memcpy(&storage, buffer, sizeof(T));
+        return *reinterpret_cast<T *>(&storage);
+    }
+
+    /**
+     * copies an object into atomic words
+     * @param words - the words
+     * @param object - the object
+     */
+    template<typename T>
+    static void _pack(std::atomic<uint64_t> *words, const T &object) noexcept
+    {
+        uint64_t buffer[(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)] = {};
+        std::memcpy(buffer, &object, sizeof(T));
+        for (size_t i = 0; i < sizeof(buffer) / sizeof(uint64_t); i++)
+        {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * makes the counter of a slot's group odd before a change
+     * @param table - the table
+     * @param idx - index of the slot
+     */
+    static void _beginWrite(Table *table, size_t idx) noexcept
+    {
+        std::atomic<uint64_t> &seq = table->groups[idx / SEQLOCK_GROUP_SIZE].seq;
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * makes the counter of a slot's group even again after a change
+     * @param table - the table
+     * @param idx - index of the slot
+     */
+    static void _endWrite(Table *table, size_t idx) noexcept
+    {
+        std::atomic<uint64_t> &seq = table->groups[idx / SEQLOCK_GROUP_SIZE].seq;
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * looks a key up in a table, validating every group it copied
+     * @param table - the table
+     * @param code - hash of the key
+     * @param key - the key
+     * @param val - receives the value if the key is found, may be nullptr
+     * @return PROBE_RETRY if a writer changed a group while it was copied
+     */
+    static ProbeResult _probe(const Table *table, size_t code, const KeyT &key,
+                              ValueT *val) noexcept
+    {
+        size_t mask = table->capacity - 1;
+        size_t idx = code & mask;
+        for (size_t scanned = 0; scanned < table->capacity;)
+        {
+            const Group &group = table->groups[idx / SEQLOCK_GROUP_SIZE];
+            uint64_t seq = group.seq.load(std::memory_order_acquire);
+            if (seq & 1u)
+            {
+                return PROBE_RETRY;
+            }
+            size_t groupEnd = (idx | (SEQLOCK_GROUP_SIZE - 1)) + 1;
+            bool decided = false;
+            ProbeResult result = PROBE_ABSENT;
+            for (; idx < groupEnd && !decided; idx++, scanned++)
+            {
+                const Slot &slot = group.slots[idx % SEQLOCK_GROUP_SIZE];
+                if (slot.state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_EMPTY)
+                {
+                    decided = true;
+                }
+                else if (_unpack<KeyT>(slot.key) == key)
+                {
+                    if (val != nullptr)
+                    {
+                        *val = _unpack<ValueT>(slot.value);
+                    }
+                    decided = true;
+                    result = PROBE_FOUND;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (group.seq.load(std::memory_order_relaxed) != seq)
+            {
+                return PROBE_RETRY;
+            }
+            if (decided)
+            {
+                return result;
+            }
+            idx &= mask;
+        }
+        return PROBE_ABSENT;
+    }
+
+    /**
+     * optimistic lookup, retried until it copied a consistent state
+     * @param key - the key
+     * @param val - receives the value if the key is found, may be nullptr
+     * @return true if the key is in the map
+     */
+    bool _read(const KeyT &key, ValueT *val) const noexcept
+    {
+        size_t code = _hashCode(key);
+        while (true)
+        {
+            uint64_t shifts = _shiftSeq.load(std::memory_order_acquire);
+            if (shifts & 1u)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            const Table *table = _table.load(std::memory_order_acquire);
+            ProbeResult result = _probe(table, code, key, val);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (result != PROBE_RETRY && _shiftSeq.load(std::memory_order_relaxed) == shifts &&
+                _table.load(std::memory_order_relaxed) == table)
+            {
+                return result == PROBE_FOUND;
+            }
+        }
+    }
+
+    /**
+     * finds the slot of a key or the empty slot ending its probe, the write lock must be held
+     * @param table - the table
+     * @param code - hash of the key
+     * @param key - the key
+     * @return index of the slot
+     */
+    static size_t _findSlot(const Table *table, size_t code, const KeyT &key) noexcept
+    {
+        size_t mask = table->capacity - 1;
+        size_t idx = code & mask;
+        while (table->slot(idx).state.load(std::memory_order_relaxed) != SEQLOCK_SLOT_EMPTY &&
+               !(_unpack<KeyT>(table->slot(idx).key) == key))
+        {
+            idx = (idx + 1) & mask;
+        }
+        return idx;
+    }
+
+    /**
+     * stores an element in an empty slot of a table no reader can see yet
+     * @param table - the table
+     * @param key - the key
+     * @param val - the value
+     */
+    static void _place(Table *table, const KeyT &key, const ValueT &val) noexcept
+    {
+        size_t idx = _findSlot(table, _hashCode(key), key);
+        Slot &slot = table->slot(idx);
+        _pack(slot.key, key);
+        _pack(slot.value, val);
+        slot.state.store(SEQLOCK_SLOT_FULL, std::memory_order_relaxed);
+    }
+
+    /**
+     * publishes a copy of the map in a table twice as large, the write lock must be held
+     */
+    void _grow() noexcept(false)
+    {
+        Table *oldTable = _table.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> newTable(new Table(oldTable->capacity * 2));
+        for (size_t i = 0; i < oldTable->capacity; i++)
+        {
+            const Slot &slot = oldTable->slot(i);
+            if (slot.state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_FULL)
+            {
+                _place(newTable.get(), _unpack<KeyT>(slot.key), _unpack<ValueT>(slot.value));
+            }
+        }
+        _retired.reserve(_retired.size() + 1);
+        _table.store(newTable.release(), std::memory_order_release);
+        _retired.emplace_back(oldTable);
+    }
+
+    /**
+     * inserts or assigns under the write lock
+     * @param key - the key
+     * @param val - the value
+     * @param assign - true to overwrite the value of an existing key
+     * @return true if the key was inserted
+     */
+    bool _write(const KeyT &key, const ValueT &val, bool assign) noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        Table *table = _table.load(std::memory_order_relaxed);
+        size_t idx = _findSlot(table, code, key);
+        Slot *slot = &table->slot(idx);
+        bool inserted = slot->state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_EMPTY;
+        if (!inserted && !assign)
+        {
+            return false;
+        }
+        if (inserted && (size() + 1) * SEQLOCK_MAX_LOAD_DENOMINATOR >
+                        table->capacity * SEQLOCK_MAX_LOAD_NUMERATOR)
+        {
+            _grow();
+            table = _table.load(std::memory_order_relaxed);
+            idx = _findSlot(table, code, key);
+            slot = &table->slot(idx);
+        }
+        _beginWrite(table, idx);
+        if (inserted)
+        {
+            _pack(slot->key, key);
+        }
+        _pack(slot->value, val);
+        slot->state.store(SEQLOCK_SLOT_FULL, std::memory_order_relaxed);
+        _endWrite(table, idx);
+        if (inserted)
+        {
+            _size.store(size() + 1, std::memory_order_relaxed);
+        }
+        return inserted;
+    }
+
+    /**
+     * updates the value of a key in place, or inserts the key, under the write lock
+     * @param key - the key
+     * @param init - value of the key if it is inserted, nullptr to never insert
+     * @param fn - called with a copy of the value, which is then stored back
+     * @return true if the key was in the map
+     */
+    template<typename Function>
+    bool _modify(const KeyT &key, const ValueT *init, Function &fn) noexcept(false)
+    {
+        Table *table = _table.load(std::memory_order_relaxed);
+        size_t idx = _findSlot(table, _hashCode(key), key);
+        Slot &slot = table->slot(idx);
+        if (slot.state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_EMPTY)
+        {
+            if (init != nullptr)
+            {
+                _write(key, *init, false);
+            }
+            return false;
+        }
+        ValueT val = _unpack<ValueT>(slot.value);
+        fn(val);
+        _beginWrite(table, idx);
+        _pack(slot.value, val);
+        _endWrite(table, idx);
+        return true;
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the SeqLockHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty SeqLockHashMap
+     */
+    SeqLockHashMap() : _table(new Table(SEQLOCK_DEFAULT_CAPACITY)), _size(0), _shiftSeq(0)
+    {
+    }
+
+    SeqLockHashMap(const SeqLockHashMap &other) = delete;
+
+    SeqLockHashMap &operator=(const SeqLockHashMap &other) = delete;
+
+    /**
+     * destructor, no other thread may use the map
+     */
+    ~SeqLockHashMap()
+    {
+        delete _table.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return number of elements
+     */
+    size_t size() const noexcept
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return true if the map is empty
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * the function checks if a certain key is in the map, without locking
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept
+    {
+        return _read(key, nullptr);
+    }
+
+    /**
+     * the function gets a key and copies its value, without locking
+     * @param key - the key
+     * @param val - receives the value if the key is in the map
+     * @return true if the key is in the map
+     */
+    bool find(const KeyT &key, ValueT &val) const noexcept
+    {
+        return _read(key, &val);
+    }
+
+    /**
+     * the function gets a key and returns a copy of its value, without locking. in case the key
+     * is not in the map an exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT at(const KeyT &key) const noexcept(false)
+    {
+        typename std::aligned_storage<sizeof(ValueT), alignof(ValueT)>::type storage;
+        ValueT *val = reinterpret_cast<ValueT *>(&storage);
+        if (!_read(key, val))
+        {
+            throw KeyNotFound{};
+        }
+        return *val;
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        return _write(key, val, false);
+    }
+
+    /**
+     * inserts a key with a value, or assigns the value if the key is already in the map
+     * @param key - the key
+     * @param val - the value
+     * @return true if the key was inserted
+     */
+    bool insert_or_assign(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        return _write(key, val, true);
+    }
+
+    /**
+     * inserts a key with init if it is not in the map yet, otherwise updates its value
+     * @param key - the key
+     * @param init - value of the key if it is inserted
+     * @param fn - called with a ValueT & if the key is already in the map, under the write lock
+     * @return the key's value after the update
+     */
+    template<typename Function>
+    ValueT upsert(const KeyT &key, const ValueT &init, Function fn) noexcept(false)
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        ValueT result = init;
+        auto update = [&fn, &result](ValueT &val)
+        {
+            fn(val);
+            result = val;
+        };
+        _modify(key, &init, update);
+        return result;
+    }
+
+    /**
+     * updates the value of a key, if the key is in the map
+     * @param key - the key
+     * @param fn - called with a ValueT & if the key is in the map, under the write lock
+     * @return true if the key is in the map
+     */
+    template<typename Function>
+    bool compute_if_present(const KeyT &key, Function fn) noexcept(false)
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        return _modify(key, nullptr, fn);
+    }
+
+    /**
+     * adds to the value of a key, inserting the key with delta if it is not in the map. readers
+     * see either the old or the new value
+     * @param key - the key
+     * @param delta - the addend
+     * @return the value before the addition, ValueT() if the key was inserted
+     */
+    template<typename V = ValueT,
+             typename = typename std::enable_if<std::is_arithmetic<V>::value>::type>
+    ValueT fetch_add(const KeyT &key, ValueT delta) noexcept(false)
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        ValueT old = ValueT();
+        auto add = [&old, delta](ValueT &val)
+        {
+            old = val;
+            val += delta;
+        };
+        _modify(key, &delta, add);
+        return old;
+    }
+
+    /**
+     * the function gets a key and erases its value, shifting back the elements after it
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        Table *table = _table.load(std::memory_order_relaxed);
+        size_t mask = table->capacity - 1;
+        size_t hole = _findSlot(table, _hashCode(key), key);
+        if (table->slot(hole).state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_EMPTY)
+        {
+            return false;
+        }
+        _shiftSeq.store(_shiftSeq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t next = (hole + 1) & mask;
+             table->slot(next).state.load(std::memory_order_relaxed) == SEQLOCK_SLOT_FULL;
+             next = (next + 1) & mask)
+        {
+            const Slot &moving = table->slot(next);
+            size_t home = _hashCode(_unpack<KeyT>(moving.key)) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                _beginWrite(table, hole);
+                Slot &target = table->slot(hole);
+                for (size_t w = 0; w < KEY_WORDS; w++)
+                {
+                    target.key[w].store(moving.key[w].load(std::memory_order_relaxed),
+                                        std::memory_order_relaxed);
+                }
+                for (size_t w = 0; w < VALUE_WORDS; w++)
+                {
+                    target.value[w].store(moving.value[w].load(std::memory_order_relaxed),
+                                          std::memory_order_relaxed);
+                }
+                _endWrite(table, hole);
+                hole = next;
+            }
+        }
+        _beginWrite(table, hole);
+        table->slot(hole).state.store(SEQLOCK_SLOT_EMPTY, std::memory_order_relaxed);
+        _endWrite(table, hole);
+        _shiftSeq.store(_shiftSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        _size.store(size() - 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * clears the map from all elements, keeping its capacity
+     */
+    void clear() noexcept
+    {
+        std::lock_guard<SpinLock> lock(_writeLock);
+        Table *table = _table.load(std::memory_order_relaxed);
+        _shiftSeq.store(_shiftSeq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < table->capacity; i++)
+        {
+            _beginWrite(table, i);
+            table->slot(i).state.store(SEQLOCK_SLOT_EMPTY, std::memory_order_relaxed);
+            _endWrite(table, i);
+        }
+        _shiftSeq.store(_shiftSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        _size.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * picks the concurrent map for KeyT and ValueT: SeqLockHashMap when both are trivially copyable
+ * and an element is small, the sharded ConcurrentHashMap otherwise
+ */
+template<typename KeyT, typename ValueT, bool = std::is_trivially_copyable<KeyT>::value &&
+                                               std::is_trivially_copyable<ValueT>::value &&
+                                               sizeof(KeyT) + sizeof(ValueT) <=
+                                               SEQLOCK_MAX_ELEMENT_SIZE>
+struct ConcurrentMapSelector
+{
+    typedef ConcurrentHashMap<KeyT, ValueT> type;
+};
+
+template<typename KeyT, typename ValueT>
+struct ConcurrentMapSelector<KeyT, ValueT, true>
+{
+    typedef SeqLockHashMap<KeyT, ValueT> type;
+};
+
+/**
+ * the concurrent map best suited for KeyT and ValueT
+ */
+template<typename KeyT, typename ValueT>
+using ConcurrentMap = typename ConcurrentMapSelector<KeyT, ValueT>::type;
+
+
+#endif //EX6_SEQLOCKHASHMAP_HPP
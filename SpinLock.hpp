@@ -0,0 +1,34 @@
+#ifndef EX6_SPINLOCK_HPP
+#define EX6_SPINLOCK_HPP
+
+// ------------------------------ includes ------------------------------
+#include <atomic>
+#include <thread>
+
+// ------------------------------ functions -----------------------------
+/**
+ * a lock that is a flag spun on, yielding between tries. for critical sections of a few
+ * instructions, where a mutex would cost more than the work it guards
+ */
+class SpinLock
+{
+private:
+    std::atomic<bool> _locked{false};
+
+public:
+    void lock() noexcept
+    {
+        while (_locked.exchange(true, std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() noexcept
+    {
+        _locked.store(false, std::memory_order_release);
+    }
+};
+
+
+#endif //EX6_SPINLOCK_HPP
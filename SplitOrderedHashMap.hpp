@@ -0,0 +1,584 @@
+#ifndef EX6_SPLITORDEREDHASHMAP_HPP
+#define EX6_SPLITORDEREDHASHMAP_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <stdexcept>
+#include "HashMix.hpp"
+#include "Epoch.hpp"
+
+// -------------------------- const definitions -------------------------
+#define SPLIT_ORDERED_DEFAULT_BUCKETS 16
+#define SPLIT_ORDERED_LOAD_FACTOR 2
+#define SPLIT_ORDERED_SEGMENTS 64
+#define SPLIT_ORDERED_RECLAIM_BATCH 64
+#define SPLIT_ORDERED_MARK ((uintptr_t) 1)
+
+// ------------------------------ functions -----------------------------
+/**
+ * @param x - a value
+ * @return the value with its bits in reverse order
+ */
+inline uint64_t splitOrderReverse(uint64_t x) noexcept
+{
+    x = ((x >> 1u) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1u);
+    x = ((x >> 2u) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2u);
+    x = ((x >> 4u) & 0x0f0f0f0f0f0f0f0fULL) | ((x & 0x0f0f0f0f0f0f0f0fULL) << 4u);
+    x = ((x >> 8u) & 0x00ff00ff00ff00ffULL) | ((x & 0x00ff00ff00ff00ffULL) << 8u);
+    x = ((x >> 16u) & 0x0000ffff0000ffffULL) | ((x & 0x0000ffff0000ffffULL) << 16u);
+    return (x >> 32u) | (x << 32u);
+}
+
+/**
+ * concurrent HashMap containing KeyT and ValueT that grows without ever moving an element
+ * (split-ordered lists, Shalev and Shavit). all the elements live in one lock-free sorted list,
+ * ordered by their bit reversed hash, and a bucket is only a shortcut into the list: a dummy node
+ * marking where the elements of the bucket start. doubling the bucket count is a single atomic
+ * store - a new bucket is initialized lazily by the first thread that touches it, by splicing its
+ * dummy into the part of the list its parent bucket covers. so neither readers nor writers ever
+ * wait for a resize, and the work of a resize is spread over the threads that use the map.
+ * searching and linking the list is lock-free. erased elements are reclaimed through an epoch
+ * domain, whose retire list is guarded by a mutex: a thread that unlinks an element takes it to
+ * retire the element, and every SPLIT_ORDERED_RECLAIM_BATCH retirements frees the ones no reader
+ * can still see while holding it. so an insert, erase or lookup that unlinks a node may wait on
+ * that lock
+ */
+template<typename KeyT, typename ValueT>
+class SplitOrderedHashMap
+{
+private:
+    /**
+     * a node of the list. dummy nodes have an even order, elements an odd one
+     */
+    struct Node
+    {
+        /**
+         * the bit reversed hash
+         */
+        size_t order;
+        /**
+         * the next node, with SPLIT_ORDERED_MARK set once this node is erased
+         */
+        std::atomic<uintptr_t> next;
+
+        explicit Node(size_t nodeOrder) noexcept : order(nodeOrder), next(0)
+        {
+        }
+    };
+
+    /**
+     * a node holding an element, never changed after it is published except for its link
+     */
+    struct Element : Node
+    {
+        std::pair<KeyT, ValueT> item;
+
+        Element(size_t nodeOrder, const KeyT &key, const ValueT &val) : Node(nodeOrder),
+                                                                         item(key, val)
+        {
+        }
+    };
+
+    /**
+     * a position in the list: the link pointing at cur, and cur's successor
+     */
+    struct Window
+    {
+        std::atomic<uintptr_t> *prev;
+        Node *cur;
+        uintptr_t next;
+    };
+
+    typedef std::atomic<Node *> BucketSlot;
+
+    /**
+     * segments of the bucket directory. segment 0 holds bucket 0 and segment s > 0 holds buckets
+     * [2^(s-1), 2^s), so growing allocates a new segment and never copies the old ones
+     */
+    mutable std::atomic<BucketSlot *> _segments[SPLIT_ORDERED_SEGMENTS];
+    /**
+     * number of buckets in use - a power of two that only grows
+     */
+    std::atomic<size_t> _bucketCount;
+    /**
+     * number of elements
+     */
+    std::atomic<size_t> _size;
+    /**
+     * reclaims erased elements
+     */
+    mutable EpochDomain _epochs;
+    /**
+     * guards the retire list of the epoch domain
+     */
+    mutable std::mutex _retireLock;
+
+    /**
+     * @param link - a link
+     * @return the node a link points at
+     */
+    static Node *_node(uintptr_t link) noexcept
+    {
+        return reinterpret_cast<Node *>(link & ~SPLIT_ORDERED_MARK);
+    }
+
+    /**
+     * @param link - a link
+     * @return true if the node holding the link is erased
+     */
+    static bool _marked(uintptr_t link) noexcept
+    {
+        return (link & SPLIT_ORDERED_MARK) != 0;
+    }
+
+    /**
+     * @param key - a key
+     * @return the mixed hash of the key
+     */
+    static size_t _hashCode(const KeyT &key) noexcept
+    {
+        return mixHash(std::hash<KeyT>{}(key));
+    }
+
+    /**
+     * @param code - hash of an element
+     * @return order of the element, always odd
+     */
+    static size_t _elementOrder(size_t code) noexcept
+    {
+        return (size_t) splitOrderReverse(code) | 1u;
+    }
+
+    /**
+     * @param bucket - index of a bucket
+     * @return order of the bucket's dummy node, always even
+     */
+    static size_t _dummyOrder(size_t bucket) noexcept
+    {
+        return (size_t) splitOrderReverse(bucket);
+    }
+
+    /**
+     * @param bucket - index of a bucket
+     * @return index of the bucket's segment
+     */
+    static size_t _segmentOf(size_t bucket) noexcept
+    {
+        size_t segment = 0;
+        while (bucket != 0)
+        {
+            bucket >>= 1u;
+            segment++;
+        }
+        return segment;
+    }
+
+    /**
+     * @param segment - index of a segment
+     * @return index of the segment's first bucket
+     */
+    static size_t _segmentStart(size_t segment) noexcept
+    {
+        return segment == 0 ? 0 : (size_t) 1 << (segment - 1);
+    }
+
+    /**
+     * @param bucket - index of a bucket
+     * @return the directory slot of the bucket, allocating its segment if needed
+     */
+    BucketSlot &_slot(size_t bucket) const noexcept(false)
+    {
+        size_t segment = _segmentOf(bucket);
+        BucketSlot *slots = _segments[segment].load(std::memory_order_acquire);
+        if (slots == nullptr)
+        {
+            size_t length = segment == 0 ? 1 : _segmentStart(segment);
+            BucketSlot *fresh = new BucketSlot[length];
+            for (size_t i = 0; i < length; i++)
+            {
+                fresh[i].store(nullptr, std::memory_order_relaxed);
+            }
+            if (_segments[segment].compare_exchange_strong(slots, fresh,
+                                                           std::memory_order_acq_rel))
+            {
+                slots = fresh;
+            }
+            else
+            {
+                delete[] fresh;
+            }
+        }
+        return slots[bucket - _segmentStart(segment)];
+    }
+
+    /**
+     * @param bucket - index of a bucket
+     * @return the dummy node of the bucket, initializing the bucket if needed
+     */
+    Node *_bucket(size_t bucket) const noexcept(false)
+    {
+        BucketSlot &slot = _slot(bucket);
+        Node *dummy = slot.load(std::memory_order_acquire);
+        if (dummy != nullptr)
+        {
+            return dummy;
+        }
+        size_t parent = bucket & ~((size_t) 1 << (_segmentOf(bucket) - 1));
+        Node *start = _bucket(parent);
+        Node *fresh = new Node(_dummyOrder(bucket));
+        Window window;
+        while (true)
+        {
+            if (_search(start, fresh->order, nullptr, window))
+            {
+                delete fresh;
+                dummy = window.cur;
+                break;
+            }
+            fresh->next.store((uintptr_t) window.cur, std::memory_order_relaxed);
+            uintptr_t expected = (uintptr_t) window.cur;
+            if (window.prev->compare_exchange_strong(expected, (uintptr_t) fresh,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+            {
+                dummy = fresh;
+                break;
+            }
+        }
+        slot.store(dummy, std::memory_order_release);
+        return dummy;
+    }
+
+    /**
+     * @param code - hash of a key
+     * @return the dummy node of the key's bucket
+     */
+    Node *_bucketOf(size_t code) const noexcept(false)
+    {
+        return _bucket(code & (_bucketCount.load(std::memory_order_acquire) - 1));
+    }
+
+    /**
+     * hands an unlinked element to the epoch domain
+     * @param node - the element
+     */
+    void _retire(Node *node) const noexcept(false)
+    {
+        std::lock_guard<std::mutex> guard(_retireLock);
+        _epochs.retire(static_cast<Element *>(node));
+        if (_epochs.pending() >= SPLIT_ORDERED_RECLAIM_BATCH)
+        {
+            _epochs.reclaim();
+        }
+    }
+
+    /**
+     * finds the window of an order and key after a given node, unlinking the erased nodes it
+     * passes. the caller must be pinned
+     * @param start - the node to start from
+     * @param order - the order looked for
+     * @param key - the key looked for, nullptr for a dummy node
+     * @param window - receives the position of the node, or of the first node after it
+     * @return true if the node was found
+     */
+    bool _search(Node *start, size_t order, const KeyT *key, Window &window) const noexcept(false)
+    {
+        bool restart = true;
+        while (restart)
+        {
+            restart = false;
+            window.prev = &start->next;
+            window.cur = _node(window.prev->load(std::memory_order_acquire));
+            while (window.cur != nullptr)
+            {
+                window.next = window.cur->next.load(std::memory_order_acquire);
+                if (_marked(window.next))
+                {
+                    uintptr_t expected = (uintptr_t) window.cur;
+                    if (!window.prev->compare_exchange_strong(expected,
+                                                              window.next & ~SPLIT_ORDERED_MARK,
+                                                              std::memory_order_acq_rel))
+                    {
+                        restart = true;
+                        break;
+                    }
+                    _retire(window.cur);
+                    window.cur = _node(window.next);
+                    continue;
+                }
+                if (window.cur->order > order)
+                {
+                    return false;
+                }
+                if (window.cur->order == order &&
+                    (key == nullptr || static_cast<Element *>(window.cur)->item.first == *key))
+                {
+                    return true;
+                }
+                window.prev = &window.cur->next;
+                window.cur = _node(window.next);
+            }
+        }
+        return false;
+    }
+
+    /**
+     * finds the element of a key without changing the list. the caller must be pinned
+     * @param key - the key
+     * @return the element, or nullptr if the key is not in the map
+     */
+    const Element *_findElement(const KeyT &key) const noexcept(false)
+    {
+        size_t code = _hashCode(key);
+        size_t order = _elementOrder(code);
+        Node *node = _bucketOf(code);
+        while (node != nullptr && node->order <= order)
+        {
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            if (node->order == order && !_marked(next) &&
+                static_cast<Element *>(node)->item.first == key)
+            {
+                return static_cast<Element *>(node);
+            }
+            node = _node(next);
+        }
+        return nullptr;
+    }
+
+    // -------------------------- exception classes -------------------------
+
+    /**
+     * exception thrown if a given key is not found in the SplitOrderedHashMap
+     */
+    class KeyNotFound : public std::exception
+    {
+        virtual const char *what() const noexcept
+        {
+            return "key is not found";
+        }
+    };
+
+public:
+    /**
+     * constructs an empty SplitOrderedHashMap
+     */
+    SplitOrderedHashMap() : _bucketCount(SPLIT_ORDERED_DEFAULT_BUCKETS), _size(0)
+    {
+        for (size_t i = 0; i < SPLIT_ORDERED_SEGMENTS; i++)
+        {
+            _segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+        _slot(0).store(new Node(_dummyOrder(0)), std::memory_order_release);
+    }
+
+    SplitOrderedHashMap(const SplitOrderedHashMap &other) = delete;
+
+    SplitOrderedHashMap &operator=(const SplitOrderedHashMap &other) = delete;
+
+    /**
+     * destructor, no other thread may use the map
+     */
+    ~SplitOrderedHashMap()
+    {
+        Node *node = _slot(0).load(std::memory_order_relaxed);
+        while (node != nullptr)
+        {
+            Node *next = _node(node->next.load(std::memory_order_relaxed));
+            if (node->order & 1u)
+            {
+                delete static_cast<Element *>(node);
+            }
+            else
+            {
+                delete node;
+            }
+            node = next;
+        }
+        for (size_t i = 0; i < SPLIT_ORDERED_SEGMENTS; i++)
+        {
+            delete[] _segments[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @return number of elements
+     */
+    size_t size() const noexcept
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return true if the map is empty
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @return number of buckets in use
+     */
+    size_t bucket_count() const noexcept
+    {
+        return _bucketCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * the function gets a key and a value, and inserts them to the map. when the load passes
+     * SPLIT_ORDERED_LOAD_FACTOR the bucket count is doubled, which moves nothing
+     * @param key - the key
+     * @param val - the value
+     * @return - true if the insertion ended successfully, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &val) noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        size_t code = _hashCode(key);
+        Node *start = _bucketOf(code);
+        Element *fresh = new Element(_elementOrder(code), key, val);
+        Window window;
+        while (true)
+        {
+            if (_search(start, fresh->order, &key, window))
+            {
+                delete fresh;
+                return false;
+            }
+            fresh->next.store((uintptr_t) window.cur, std::memory_order_relaxed);
+            uintptr_t expected = (uintptr_t) window.cur;
+            if (window.prev->compare_exchange_strong(expected, (uintptr_t) fresh,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        size_t newSize = _size.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t buckets = _bucketCount.load(std::memory_order_relaxed);
+        if (newSize > buckets * SPLIT_ORDERED_LOAD_FACTOR &&
+            _segmentOf(buckets) < SPLIT_ORDERED_SEGMENTS)
+        {
+            _bucketCount.compare_exchange_strong(buckets, buckets * 2, std::memory_order_release,
+                                                 std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * the function gets a key and erases its value. the element is marked first, so no insert can
+     * link after it, and then unlinked by this thread or by the next one passing it
+     * @param key - the key
+     * @return - true if the erase was done successfully
+     */
+    bool erase(const KeyT &key) noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        size_t code = _hashCode(key);
+        size_t order = _elementOrder(code);
+        Node *start = _bucketOf(code);
+        Window window;
+        while (true)
+        {
+            if (!_search(start, order, &key, window))
+            {
+                return false;
+            }
+            if (window.cur->next.compare_exchange_strong(window.next,
+                                                         window.next | SPLIT_ORDERED_MARK,
+                                                         std::memory_order_acq_rel))
+            {
+                break;
+            }
+        }
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        uintptr_t expected = (uintptr_t) window.cur;
+        if (window.prev->compare_exchange_strong(expected, window.next,
+                                                 std::memory_order_acq_rel))
+        {
+            _retire(window.cur);
+        }
+        else
+        {
+            _search(start, order, &key, window);
+        }
+        return true;
+    }
+
+    /**
+     * the function checks if a certain key is in the map
+     * @param key - the key we are looking for
+     * @return - true if it does
+     */
+    bool contains_key(const KeyT &key) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        return _findElement(key) != nullptr;
+    }
+
+    /**
+     * the function gets a key and copies its value
+     * @param key - the key
+     * @param val - receives the value if the key is in the map
+     * @return true if the key is in the map
+     */
+    bool find(const KeyT &key, ValueT &val) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        const Element *element = _findElement(key);
+        if (element == nullptr)
+        {
+            return false;
+        }
+        val = element->item.second;
+        return true;
+    }
+
+    /**
+     * the function gets a key and returns a copy of its value. in case the key is not in the map
+     * an exception is thrown
+     * @param key - the key
+     * @return - key's value
+     */
+    ValueT at(const KeyT &key) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        const Element *element = _findElement(key);
+        if (element == nullptr)
+        {
+            throw KeyNotFound{};
+        }
+        return element->item.second;
+    }
+
+    /**
+     * calls a function with every element, walking the list while other threads use the map.
+     * every element present for the whole walk is visited exactly once
+     * @param fn - called with a const std::pair<KeyT, ValueT> &
+     */
+    template<typename Function>
+    void for_each(Function fn) const noexcept(false)
+    {
+        EpochDomain::Guard guard = _epochs.pin();
+        Node *node = _segments[0].load(std::memory_order_acquire)[0].load(
+                std::memory_order_acquire);
+        while (node != nullptr)
+        {
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            if ((node->order & 1u) && !_marked(next))
+            {
+                fn(static_cast<const std::pair<KeyT, ValueT> &>(
+                           static_cast<Element *>(node)->item));
+            }
+            node = _node(next);
+        }
+    }
+};
+
+
+#endif //EX6_SPLITORDEREDHASHMAP_HPP
@@ -0,0 +1,298 @@
+#ifndef EX6_WORKSTEALINGPOOL_HPP
+#define EX6_WORKSTEALINGPOOL_HPP
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <exception>
+
+// -------------------------- const definitions -------------------------
+#define POOL_CHUNKS_PER_WORKER 8
+
+// ------------------------------ functions -----------------------------
+/**
+ * a fixed set of worker threads, each with its own task deque. a worker takes the newest task of
+ * its own deque and, once that is empty, steals the oldest task of another worker, so a worker
+ * that finished its share keeps busy with the chunks others did not get to. a thread waiting for
+ * a parallel_for runs tasks too, so nested parallel_for calls do not deadlock
+ */
+class WorkStealingPool
+{
+private:
+    /**
+     * the task deque of a worker
+     */
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /**
+     * the pool and worker index of the calling thread
+     */
+    struct ThreadRole
+    {
+        const WorkStealingPool *pool;
+        size_t index;
+    };
+
+    /**
+     * the worker deques
+     */
+    std::unique_ptr<Worker[]> _workers;
+    /**
+     * number of workers
+     */
+    size_t _workerCount;
+    /**
+     * the worker threads
+     */
+    std::vector<std::thread> _threads;
+    /**
+     * number of tasks in all deques
+     */
+    std::atomic<size_t> _queued;
+    /**
+     * next worker to get a task pushed by a thread outside the pool
+     */
+    std::atomic<size_t> _nextWorker;
+    /**
+     * guards the sleep of idle workers
+     */
+    std::mutex _sleepLock;
+    /**
+     * wakes idle workers
+     */
+    std::condition_variable _wake;
+    /**
+     * set when the pool is destroyed
+     */
+    bool _stopping;
+
+    /**
+     * @return the role of the calling thread
+     */
+    static ThreadRole &_role() noexcept
+    {
+        static thread_local ThreadRole role{nullptr, 0};
+        return role;
+    }
+
+    /**
+     * pushes a task to the deque of the calling worker, or of the next worker in turn
+     * @param task - the task
+     */
+    void _push(std::function<void()> task) noexcept(false)
+    {
+        size_t index = _role().pool == this ? _role().index
+                                            : _nextWorker.fetch_add(1) % _workerCount;
+        {
+            std::lock_guard<std::mutex> guard(_workers[index].lock);
+            _workers[index].tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> guard(_sleepLock);
+            _queued.fetch_add(1);
+        }
+        _wake.notify_one();
+    }
+
+    /**
+     * runs one task, the newest of the given worker's deque or the oldest of another one's
+     * @param self - index of the worker to start with
+     * @return true if a task was run
+     */
+    bool _runOne(size_t self) noexcept
+    {
+        std::function<void()> task;
+        for (size_t i = 0; i < _workerCount && !task; i++)
+        {
+            Worker &worker = _workers[(self + i) % _workerCount];
+            std::lock_guard<std::mutex> guard(worker.lock);
+            if (worker.tasks.empty())
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+        }
+        if (!task)
+        {
+            return false;
+        }
+        _queued.fetch_sub(1);
+        task();
+        return true;
+    }
+
+    /**
+     * the loop of a worker thread
+     * @param index - index of the worker
+     */
+    void _work(size_t index) noexcept
+    {
+        _role() = {this, index};
+        while (true)
+        {
+            if (_runOne(index))
+            {
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(_sleepLock);
+            _wake.wait(guard, [this]()
+                       {
+                           return _stopping || _queued.load() > 0;
+                       });
+            if (_stopping && _queued.load() == 0)
+            {
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * starts the workers
+     * @param threads - number of worker threads, at least one
+     */
+    explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency()) :
+            _workerCount(threads > 0 ? threads : 1), _queued(0), _nextWorker(0), _stopping(false)
+    {
+        _workers.reset(new Worker[_workerCount]);
+        for (size_t i = 0; i < _workerCount; i++)
+        {
+            _threads.emplace_back(&WorkStealingPool::_work, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &other) = delete;
+
+    WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+    /**
+     * runs the queued tasks and joins the workers
+     */
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(_sleepLock);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (std::thread &thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @return number of worker threads
+     */
+    size_t size() const noexcept
+    {
+        return _workerCount;
+    }
+
+    /**
+     * splits [begin, end) into chunks of at least grain indices, runs fn on every chunk in the
+     * pool, and returns once all chunks are done. the calling thread runs chunks as well. if fn
+     * throws, the first exception is rethrown once all chunks are done
+     * @param begin - first index
+     * @param end - one past the last index
+     * @param fn - called with (chunkBegin, chunkEnd), possibly from several threads at once
+     * @param grain - minimal chunk size
+     */
+    template<typename Function>
+    void parallel_for(size_t begin, size_t end, Function fn, size_t grain = 1) noexcept(false)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+        size_t length = end - begin;
+        size_t chunks = _workerCount * POOL_CHUNKS_PER_WORKER;
+        if (grain == 0)
+        {
+            grain = 1;
+        }
+        if (chunks > (length + grain - 1) / grain)
+        {
+            chunks = (length + grain - 1) / grain;
+        }
+        if (chunks <= 1)
+        {
+            fn(begin, end);
+            return;
+        }
+        std::atomic<size_t> remaining(chunks);
+        std::exception_ptr error;
+        std::mutex errorLock;
+        auto runChunk = [&](size_t chunk)
+        {
+            try
+            {
+                fn(begin + length * chunk / chunks, begin + length * (chunk + 1) / chunks);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        };
+        size_t pushed = 1;
+        try
+        {
+            for (; pushed < chunks; pushed++)
+            {
+                size_t chunk = pushed;
+                _push([&runChunk, chunk]()
+                      {
+                          runChunk(chunk);
+                      });
+            }
+        }
+        catch (...)
+        {
+            // the chunks that were not pushed are given up, the pushed ones still use this frame
+            std::lock_guard<std::mutex> guard(errorLock);
+            error = std::current_exception();
+            remaining.fetch_sub(chunks - pushed, std::memory_order_acq_rel);
+        }
+        runChunk(0);
+        size_t self = _role().pool == this ? _role().index : 0;
+        while (remaining.load(std::memory_order_acquire) != 0)
+        {
+            if (!_runOne(self))
+            {
+                std::this_thread::yield();
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+
+#endif //EX6_WORKSTEALINGPOOL_HPP
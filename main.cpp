@@ -4,9 +4,23 @@
 #include <filesystem>
 #include <sstream>
 #include <cassert>
+#include <cstdlib>
+#include <new>
 #include <vector>
 #include <map>
+#include <set>
+#include <cctype>
+#include <thread>
+#include <atomic>
 #include "HashMap.hpp"
+#include "FlatHashMap.hpp"
+#include "RobinHoodHashMap.hpp"
+#include "ConcurrentHashMap.hpp"
+#include "ReadMostlyHashMap.hpp"
+#include "SplitOrderedHashMap.hpp"
+#include "LeftRightHashMap.hpp"
+#include "SeqLockHashMap.hpp"
+#include "WorkStealingPool.hpp"
 
 /** \brief The number of arguments this program expects to get. */
 #define PROG_NUM_ARGS 2
@@ -73,6 +87,216 @@ int getRandomNumber(int max)
     return std::rand() % max;
 }
 
+/**
+ * hash of a string that ignores the case of its letters
+ */
+struct CaseInsensitiveHash
+{
+    size_t operator()(const std::string &key) const
+    {
+        size_t hash = 0;
+        for (char c : key)
+        {
+            hash = hash * 31 + (size_t) std::tolower((unsigned char) c);
+        }
+        return hash;
+    }
+};
+
+/**
+ * equality of strings that ignores the case of their letters
+ */
+struct CaseInsensitiveEqual
+{
+    bool operator()(const std::string &first, const std::string &second) const
+    {
+        if (first.size() != second.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < first.size(); i++)
+        {
+            if (std::tolower((unsigned char) first[i]) != std::tolower((unsigned char) second[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * hash of an integer with a state, so it is kept as a member
+ */
+struct OffsetHash
+{
+    size_t offset;
+
+    size_t operator()(int key) const
+    {
+        return (size_t) key + offset;
+    }
+};
+
+/**
+ * allocator that counts the blocks it has handed out and not taken back yet
+ */
+template<typename T>
+struct CountingAllocator
+{
+    typedef T value_type;
+
+    long *live;
+
+    explicit CountingAllocator(long *counter) : live(counter)
+    {}
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &other) : live(other.live)
+    {}
+
+    T *allocate(size_t n)
+    {
+        (*live)++;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        (*live)--;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U> &other) const
+    {
+        return live == other.live;
+    }
+
+    template<typename U>
+    bool operator!=(const CountingAllocator<U> &other) const
+    {
+        return live != other.live;
+    }
+};
+
+/**
+ * counting allocator that moves with the elements on move assignment, but not on swap
+ */
+template<typename T>
+struct MovingCountingAllocator : CountingAllocator<T>
+{
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    explicit MovingCountingAllocator(long *counter) : CountingAllocator<T>(counter)
+    {}
+
+    template<typename U>
+    MovingCountingAllocator(const MovingCountingAllocator<U> &other) :
+            CountingAllocator<T>(other.live)
+    {}
+};
+
+/**
+ * a view of characters that does not own them and does not convert to std::string, like a
+ * std::string_view
+ */
+struct Token
+{
+    const char *data;
+    size_t size;
+};
+
+/**
+ * transparent hash of strings, which hashes a std::string and a Token of the same characters alike
+ */
+struct TokenHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(Token key) const
+    {
+        size_t hash = 0;
+        for (size_t i = 0; i < key.size; i++)
+        {
+            hash = hash * 31 + (unsigned char) key.data[i];
+        }
+        return hash;
+    }
+
+    size_t operator()(const std::string &key) const
+    {
+        return (*this)(Token{key.data(), key.size()});
+    }
+};
+
+/**
+ * transparent equality of a std::string with a std::string or a Token
+ */
+struct TokenEqual
+{
+    typedef void is_transparent;
+
+    bool operator()(const std::string &first, Token second) const
+    {
+        return first.compare(0, first.size(), second.data, second.size) == 0;
+    }
+
+    bool operator()(const std::string &first, const std::string &second) const
+    {
+        return first == second;
+    }
+};
+
+/**
+ * number of calls to the global operator new while _heapCounting is set
+ */
+static std::atomic<long> _heapCalls(0);
+static std::atomic<bool> _heapCounting(false);
+
+void *operator new(size_t size)
+{
+    if (_heapCounting.load())
+    {
+        _heapCalls++;
+    }
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * monotonic memory resource that counts the blocks it is asked to free
+ */
+struct CountingMonotonicResource : std::pmr::monotonic_buffer_resource
+{
+    long deallocations = 0;
+
+    CountingMonotonicResource(void *buffer, size_t size, std::pmr::memory_resource *upstream) :
+            std::pmr::monotonic_buffer_resource(buffer, size, upstream)
+    {}
+
+protected:
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        deallocations++;
+        std::pmr::monotonic_buffer_resource::do_deallocate(p, bytes, alignment);
+    }
+};
+
 /**
  * @brief The main function that runs the program.
  * @param argc Non-negative value representing the number of arguments passed
@@ -670,6 +894,1586 @@ int main()
 
     std::cout << "====================== pass random insert and deletes ======================"
             << std::endl;
+    std::cout << "====================== incremental rehash ======================" << std::endl;
+    try
+    {
+        HashMap<int, int> map;
+        map.set_rehash_step(2);
+        assert(map.rehash_step() == 2);
+        std::map<int, int> realMap;
+        bool sawRehash = false;
+        for (int i = 0; i < 1000; i++)
+        {
+            map[i] = 3 * i;
+            realMap[i] = 3 * i;
+            sawRehash = sawRehash || map.rehashing();
+            if (map.rehashing())
+            {
+                //copies taken in the middle of a rehash are equal to the original
+                HashMap<int, int> map1(map);
+                assert(map1 == map);
+                assert(map1.size() == map.size());
+            }
+            assert(map.contains_key(i / 2));
+            assert(map.at(i / 2) == 3 * (i / 2));
+        }
+        assert(sawRehash);
+        assert(map.size() == realMap.size());
+        int counter = 0;
+        for (auto it = map.cbegin(); it != map.cend(); ++it)
+        {
+            counter++;
+            assert(realMap.at((*it).first) == (*it).second);
+        }
+        assert(counter == 1000);
+        for (int i = 0; i < 990; i++)
+        {
+            assert(map.erase(i));
+            assert(!map.contains_key(i));
+            assert(map.contains_key(i + 1));
+        }
+        assert(map.size() == 10);
+        map.set_rehash_step(0);
+        assert(!map.rehashing());
+        for (int i = 990; i < 1000; i++)
+        {
+            assert(map.at(i) == 3 * i);
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass incremental rehash ======================" <<
+              std::endl;
+    std::cout << "====================== resize policy ======================" << std::endl;
+    try
+    {
+        HashMapPolicy policy;
+        policy.maxLoadFactor = 0.9;
+        policy.minLoadFactor = 0.1;
+        policy.growthFactor = 4;
+        policy.shrinkHysteresis = 3;
+        HashMap<int, int> map(policy);
+        assert(map.policy().growthFactor == 4);
+        for (int i = 0; i < 15; i++)
+        {
+            assert(map.insert(i, i));
+        }
+        assert(map.capacity() == 64);
+        for (int i = 0; i < 10; i++)
+        {
+            assert(map.erase(i));
+        }
+        //load is under 0.1 for only 2 erases in a row
+        assert(map.capacity() == 64);
+        assert(map.insert(0, 0));
+        assert(map.erase(0));
+        assert(map.erase(10));
+        //the insert restarted the count
+        assert(map.capacity() == 64);
+        assert(map.erase(11));
+        assert(map.capacity() == 16);
+
+        HashMap<int, int> map1;
+        map1.reserve(1000);
+        assert(map1.capacity() == 2048);
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(map1.insert(i, i));
+        }
+        assert(map1.capacity() == 2048);
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(map1.erase(i));
+        }
+        //reserved capacity is kept, rehash does not go under it either
+        assert(map1.capacity() == 2048);
+        map1.rehash(0);
+        assert(map1.capacity() == 2048);
+        map1.shrink_to_fit();
+        assert(map1.capacity() == 1);
+        map1.rehash(100);
+        assert(map1.capacity() == 128);
+        try
+        {
+            policy.minLoadFactor = 0.5;
+            map1.set_policy(policy);
+            assert(false);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        try
+        {
+            // with no erase to wait for, every erase would shrink the table at any load
+            HashMapPolicy eager;
+            eager.shrinkHysteresis = 0;
+            HashMap<int, int> eagerMap(eager);
+            assert(false);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass resize policy ======================" << std::endl;
+    std::cout << "====================== find and emplace ======================" << std::endl;
+    try
+    {
+        HashMap<std::string, int> map;
+        assert(map.find("a") == map.end());
+        auto res = map.try_emplace("a", 1);
+        assert(res.second);
+        assert(res.first->first == "a" && res.first->second == 1);
+        assert(res.first == map.find("a"));
+        res = map.try_emplace("a", 2);
+        assert(!res.second);
+        assert(map.at("a") == 1);
+        res = map.insert_or_assign("a", 3);
+        assert(!res.second);
+        assert(map.at("a") == 3);
+        res = map.insert_or_assign("b", 4);
+        assert(res.second);
+        assert(map.at("b") == 4);
+        res = map.emplace("c", 5);
+        assert(res.second);
+        assert((*res.first).second == 5);
+        res = map.emplace(std::make_pair(std::string("c"), 6));
+        assert(!res.second);
+        assert(map.at("c") == 5);
+        std::string key = "d";
+        map[std::move(key)]++;
+        map["d"]++;
+        assert(map.at("d") == 2);
+        assert(map.size() == 4);
+        //iterators returned while the table grows stay valid
+        HashMap<int, int> map1;
+        for (int i = 0; i < 100; i++)
+        {
+            auto it = map1.try_emplace(i, i * i).first;
+            assert(it == map1.find(i));
+            assert(it->second == i * i);
+        }
+        int counter = 0;
+        for (auto it = map1.find(0); it != map1.end(); ++it)
+        {
+            counter++;
+        }
+        assert(counter <= 100);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass find and emplace ======================" << std::endl;
+    std::cout << "====================== move and swap ======================" << std::endl;
+    try
+    {
+        HashMap<int, int> map(_keys.begin(), _keys.end(), _values.begin(), _values.end());
+        HashMap<int, int> map1(std::move(map));
+        assert(map1.size() == 13);
+        assert(map1.capacity() == 32);
+        assert(map1.at(13) == 13);
+        //the moved from map is empty and usable
+        assert(map.empty());
+        assert(!map.contains_key(13));
+        assert(map.cbegin() == map.cend());
+        assert(map.insert(1, 1));
+        assert(map.at(1) == 1);
+
+        HashMap<int, int> map2;
+        map2 = std::move(map1);
+        assert(map2.size() == 13);
+        assert(map1.empty());
+        map1.clear();
+        map1 = map2;
+        assert(map1 == map2);
+
+        swap(map, map2);
+        assert(map.size() == 13);
+        assert(map2.size() == 1);
+        map.swap(map2);
+        assert(map.size() == 1);
+
+        std::vector<HashMap<int, int>> maps;
+        for (int i = 0; i < 10; i++)
+        {
+            maps.push_back(HashMap<int, int>(_keys.begin(), _keys.end(), _values.begin(),
+                                             _values.end()));
+        }
+        for (auto &m : maps)
+        {
+            assert(m.size() == 13);
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass move and swap ======================" << std::endl;
+    std::cout << "====================== bulk insert ======================" << std::endl;
+    try
+    {
+        std::vector<int> keys1 = {1, 2, 3, 1, 2};
+        std::vector<int> values1 = {1, 2, 3, 4, 5};
+        HashMap<int, int> map(keys1.begin(), keys1.end(), values1.begin(), values1.end());
+        //the last value of a repeated key wins
+        assert(map.size() == 3);
+        assert(map.at(1) == 4);
+        assert(map.at(2) == 5);
+
+        std::vector<std::pair<int, int>> pairs;
+        for (int i = 0; i < 1000; i++)
+        {
+            pairs.emplace_back(i, -i);
+        }
+        HashMap<int, int> map1;
+        map1.insert(pairs.begin(), pairs.end());
+        assert(map1.size() == 1000);
+        assert(map1.capacity() == 2048);
+        assert(map1.at(999) == -999);
+        //existing keys keep their values
+        map.insert(pairs.begin(), pairs.begin() + 2);
+        assert(map.at(1) == 4);
+        assert(map.at(0) == 0);
+
+        HashMap<int, int> map2;
+        map2.insert(map1.begin(), map1.end());
+        assert(map2 == map1);
+        HashMap<int, int> map3;
+        map3.reserve(5000);
+        map3.insert(map1.cbegin(), map1.cend());
+        assert(map3.size() == 1000);
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(map3.at(i) == -i);
+        }
+        map.insert(map1.begin(), map1.end());
+        assert(map.size() == 1000);
+        assert(map.at(2) == 5);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass bulk insert ======================" << std::endl;
+    std::cout << "====================== batched lookup ======================" << std::endl;
+    try
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 500; i += 2)
+        {
+            map[i] = i + 1;
+        }
+        std::vector<int> batch;
+        for (int i = 0; i < 100; i++)
+        {
+            batch.push_back(getRandomNumber(500));
+        }
+        std::vector<char> found;
+        map.contains_many(batch.begin(), batch.end(), std::back_inserter(found));
+        std::vector<HashMap<int, int>::const_iterator> its(batch.size());
+        map.find_many(batch.begin(), batch.end(), its.begin());
+        assert(found.size() == batch.size());
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            assert((bool) found[i] == (batch[i] % 2 == 0));
+            assert(its[i] == map.find(batch[i]));
+        }
+        std::vector<int> evens = {0, 2, 498}, vals;
+        map.at_many(evens.begin(), evens.end(), std::back_inserter(vals));
+        assert(vals == std::vector<int>({1, 3, 499}));
+        try
+        {
+            map.at_many(batch.begin(), batch.end(), std::back_inserter(vals));
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass batched lookup ======================" << std::endl;
+    std::cout << "====================== concurrent map ======================" << std::endl;
+    try
+    {
+        ConcurrentHashMap<int, int> map(8);
+        assert(map.shard_count() == 8);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&map, t]()
+                                 {
+                                     for (int i = t * 1000; i < (t + 1) * 1000; i++)
+                                     {
+                                         assert(map.insert(i, i * 2));
+                                         assert(map.at(i) == i * 2);
+                                     }
+                                     for (int i = t * 1000; i < (t + 1) * 1000; i += 2)
+                                     {
+                                         assert(map.erase(i));
+                                     }
+                                 });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        assert(map.size() == 2000);
+        int val = 0;
+        assert(map.find(1, val) && val == 2);
+        assert(!map.find(2, val) && !map.contains_key(2));
+        assert(!map.insert(1, 5) && !map.insert_or_assign(1, 5) && map.at(1) == 5);
+        size_t visited = 0;
+        map.for_each([&visited](const pair<int, int> &p)
+                     {
+                         assert(p.first % 2 == 1);
+                         visited++;
+                     });
+        assert(visited == map.size());
+        try
+        {
+            map.at(2);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        map.clear();
+        assert(map.empty());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass concurrent map ======================" << std::endl;
+    std::cout << "====================== read mostly map ======================" << std::endl;
+    try
+    {
+        ReadMostlyHashMap<int, std::string> map;
+        for (int i = 0; i < 100; i++)
+        {
+            assert(map.insert(i, std::to_string(i)));
+        }
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++)
+        {
+            readers.emplace_back([&map, &done]()
+                                 {
+                                     std::string val;
+                                     while (!done.load())
+                                     {
+                                         for (int i = 0; i < 100; i++)
+                                         {
+                                             assert(map.find(i, val));
+                                             assert(val == std::to_string(i) || val == "x");
+                                         }
+                                         assert(!map.contains_key(-1));
+                                     }
+                                 });
+        }
+        for (int i = 100; i < 2000; i++)
+        {
+            assert(map.insert(i, std::to_string(i)));
+        }
+        for (int i = 0; i < 100; i++)
+        {
+            assert(!map.insert_or_assign(i, "x"));
+        }
+        for (int i = 100; i < 2000; i++)
+        {
+            assert(map.erase(i));
+        }
+        done.store(true);
+        for (auto &reader : readers)
+        {
+            reader.join();
+        }
+        assert(map.size() == 100 && map.capacity() >= 2048);
+        assert(map.at(5) == "x" && !map.erase(100));
+        size_t visited = 0;
+        map.for_each([&visited](const pair<int, std::string> &p)
+                     {
+                         assert(p.second == "x");
+                         visited++;
+                     });
+        assert(visited == 100);
+        try
+        {
+            map.at(100);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        map.clear();
+        assert(map.empty() && !map.contains_key(5));
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass read mostly map ======================" << std::endl;
+    std::cout << "====================== split ordered map ======================" << std::endl;
+    try
+    {
+        SplitOrderedHashMap<int, int> map;
+        assert(map.bucket_count() == 16);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&map, t]()
+                                 {
+                                     int val = 0;
+                                     for (int i = t; i < 8000; i += 4)
+                                     {
+                                         assert(map.insert(i, -i));
+                                         assert(map.find(i, val) && val == -i);
+                                         assert(!map.insert(i, 0));
+                                     }
+                                     for (int i = t; i < 8000; i += 8)
+                                     {
+                                         assert(map.erase(i) && !map.erase(i));
+                                         assert(!map.contains_key(i));
+                                     }
+                                 });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        assert(map.size() == 4000 && map.bucket_count() >= 2048);
+        for (int i = 0; i < 8000; i++)
+        {
+            assert(map.contains_key(i) == (i % 8 >= 4));
+        }
+        assert(map.at(4) == -4);
+        size_t visited = 0;
+        map.for_each([&visited](const pair<int, int> &p)
+                     {
+                         assert(p.first == -p.second);
+                         visited++;
+                     });
+        assert(visited == map.size());
+        try
+        {
+            map.at(0);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass split ordered map ======================" << std::endl;
+    std::cout << "====================== left right map ======================" << std::endl;
+    try
+    {
+        HashMap<int, int> initial;
+        initial[0] = 0;
+        LeftRightHashMap<int, int> map(initial);
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++)
+        {
+            readers.emplace_back([&map, &done]()
+                                 {
+                                     int val = 0;
+                                     while (!done.load())
+                                     {
+                                         assert(map.find(0, val) && val >= 0);
+                                         size_t seen = map.read([](const HashMap<int, int> &m)
+                                                                {
+                                                                    return m.size();
+                                                                });
+                                         assert(seen >= 1);
+                                     }
+                                 });
+        }
+        for (int i = 1; i < 1000; i++)
+        {
+            assert(map.insert(i, i));
+            assert(!map.insert_or_assign(0, i));
+        }
+        for (int i = 1; i < 1000; i += 2)
+        {
+            assert(map.erase(i));
+        }
+        done.store(true);
+        for (auto &reader : readers)
+        {
+            reader.join();
+        }
+        assert(map.size() == 500 && map.at(0) == 999 && !map.contains_key(1));
+        assert(map.modify([](HashMap<int, int> &m)
+                          {
+                              return ++m[2];
+                          }) == 3);
+        assert(map.at(2) == 3);
+        // a change that fails on the second instance leaves both instances as the first one
+        int calls = 0;
+        try
+        {
+            map.modify([&calls](HashMap<int, int> &m)
+                       {
+                           m[1001] = 1;
+                           if (++calls == 2)
+                           {
+                               throw std::bad_alloc();
+                           }
+                           return 0;
+                       });
+            assert(false);
+        }
+        catch (const std::bad_alloc &)
+        {
+        }
+        assert(map.at(1001) == 1 && map.size() == 501);
+        map.modify([](HashMap<int, int> &)
+                   {
+                       return 0;
+                   });
+        assert(map.at(1001) == 1 && map.size() == 501);
+        // a change that fails on the first instance is dropped from it
+        try
+        {
+            map.modify([](HashMap<int, int> &m)
+                       {
+                           m[1003] = 3;
+                           throw std::bad_alloc();
+                           return 0;
+                       });
+            assert(false);
+        }
+        catch (const std::bad_alloc &)
+        {
+        }
+        assert(!map.contains_key(1003) && map.size() == 501);
+        map.modify([](HashMap<int, int> &)
+                   {
+                       return 0;
+                   });
+        assert(!map.contains_key(1003) && map.size() == 501);
+        map.clear();
+        assert(map.empty());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass left right map ======================" << std::endl;
+    std::cout << "====================== seqlock map ======================" << std::endl;
+    try
+    {
+        static_assert(std::is_same<ConcurrentMap<uint64_t, uint64_t>,
+                              SeqLockHashMap<uint64_t, uint64_t>>::value, "");
+        static_assert(std::is_same<ConcurrentMap<std::string, int>,
+                              ConcurrentHashMap<std::string, int>>::value, "");
+        ConcurrentMap<uint64_t, uint64_t> map;
+        for (uint64_t i = 0; i < 64; i++)
+        {
+            assert(map.insert(i, i * 3));
+        }
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++)
+        {
+            readers.emplace_back([&map, &done]()
+                                 {
+                                     uint64_t val = 0;
+                                     while (!done.load())
+                                     {
+                                         for (uint64_t i = 0; i < 64; i++)
+                                         {
+                                             assert(map.find(i, val) && val % 3 == 0);
+                                         }
+                                     }
+                                 });
+        }
+        for (uint64_t i = 64; i < 5000; i++)
+        {
+            assert(map.insert(i, i * 3));
+        }
+        for (uint64_t i = 0; i < 64; i++)
+        {
+            assert(!map.insert_or_assign(i, i * 6));
+        }
+        for (uint64_t i = 64; i < 5000; i += 2)
+        {
+            assert(map.erase(i));
+        }
+        done.store(true);
+        for (auto &reader : readers)
+        {
+            reader.join();
+        }
+        assert(map.size() == 2532 && map.at(10) == 60 && !map.contains_key(64));
+        for (uint64_t i = 65; i < 5000; i += 2)
+        {
+            assert(map.at(i) == i * 3);
+        }
+        assert(!map.erase(64) && !map.insert(65, 0));
+        try
+        {
+            map.at(64);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        map.clear();
+        assert(map.empty() && !map.contains_key(65));
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass seqlock map ======================" << std::endl;
+    std::cout << "====================== in place update ======================" << std::endl;
+    try
+    {
+        HashMap<std::string, int> counts;
+        assert(counts.upsert("a", 1, [](int &val) { val++; }) == 1);
+        assert(counts.upsert("a", 1, [](int &val) { val++; }) == 2);
+        assert(counts.compute_if_present("a", [](int &val) { val *= 10; }));
+        assert(!counts.compute_if_present("b", [](int &val) { val *= 10; }));
+        assert(counts.at("a") == 20 && counts.size() == 1);
+
+        ConcurrentHashMap<std::string, int> shared(4);
+        SeqLockHashMap<uint64_t, uint64_t> hot;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&shared, &hot]()
+                                 {
+                                     for (int i = 0; i < 1000; i++)
+                                     {
+                                         shared.fetch_add("key" + std::to_string(i % 10), 1);
+                                         hot.fetch_add(i % 10, 2);
+                                     }
+                                 });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        assert(shared.size() == 10 && hot.size() == 10);
+        for (int i = 0; i < 10; i++)
+        {
+            assert(shared.at("key" + std::to_string(i)) == 400);
+            assert(hot.at(i) == 800);
+        }
+        assert(shared.upsert("new", 5, [](int &val) { val = 0; }) == 5);
+        assert(shared.upsert("new", 5, [](int &val) { val = 0; }) == 0);
+        assert(shared.compute_if_present("new", [](int &val) { val = 7; }));
+        assert(shared.at("new") == 7);
+        assert(hot.fetch_add(100, 3) == 0 && hot.fetch_add(100, 3) == 3);
+        assert(hot.upsert(101, 1, [](uint64_t &val) { val = 9; }) == 1);
+        assert(hot.compute_if_present(101, [](uint64_t &val) { val = 9; }) && hot.at(101) == 9);
+        assert(!hot.compute_if_present(102, [](uint64_t &val) { val = 9; }));
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass in place update ======================" << std::endl;
+    std::cout << "====================== parallel algorithms ======================" << std::endl;
+    try
+    {
+        WorkStealingPool pool(4);
+        HashMap<int, int> map;
+        for (int i = 0; i < 20000; i++)
+        {
+            map[i] = i % 7;
+        }
+        std::atomic<long> sum(0);
+        map.parallel_for_each(pool, [&sum](const pair<int, int> &p)
+                              {
+                                  sum += p.second;
+                              });
+        long expected = 0;
+        for (auto it = map.cbegin(); it != map.cend(); ++it)
+        {
+            expected += it->second;
+        }
+        assert(sum.load() == expected);
+        long reduced = map.parallel_reduce(pool, 0L, [](const pair<int, int> &p)
+                                           {
+                                               return (long) p.second;
+                                           }, [](long a, long b)
+                                           {
+                                               return a + b;
+                                           });
+        assert(reduced == expected);
+        size_t oldCapacity = map.capacity();
+        map.parallel_rehash(pool, oldCapacity * 4);
+        assert(map.capacity() == oldCapacity * 4 && map.size() == 20000);
+        map.parallel_rehash(pool, 0);
+        assert(map.capacity() == oldCapacity && map.at(12345) == 12345 % 7);
+        size_t erased = map.parallel_erase_if(pool, [](const pair<int, int> &p)
+                                              {
+                                                  return p.first >= 100;
+                                              });
+        assert(erased == 19900 && map.size() == 100 && map.capacity() < oldCapacity);
+        for (int i = 0; i < 100; i++)
+        {
+            assert(map.at(i) == i % 7);
+        }
+        // like rehash, it does not go under the capacity reserve asked for
+        map.reserve(20000);
+        size_t reserved = map.capacity();
+        map.parallel_rehash(pool, 0);
+        assert(map.capacity() == reserved && map.at(99) == 99 % 7);
+        map.shrink_to_fit();
+        assert(map.capacity() < reserved);
+        std::atomic<int> nested(0);
+        pool.parallel_for(0, 8, [&pool, &nested](size_t first, size_t last)
+                          {
+                              for (size_t i = first; i < last; i++)
+                              {
+                                  pool.parallel_for(0, 100, [&nested](size_t b, size_t e)
+                                                    {
+                                                        nested += (int) (e - b);
+                                                    });
+                              }
+                          });
+        assert(nested.load() == 800);
+        try
+        {
+            pool.parallel_for(0, 100, [](size_t, size_t)
+                              {
+                                  throw std::out_of_range("chunk failed");
+                              });
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass parallel algorithms ======================" << std::endl;
+    std::cout << "====================== parallel build ======================" << std::endl;
+    try
+    {
+        std::vector<int> keys, values;
+        for (int i = 0; i < 50000; i++)
+        {
+            keys.push_back(getRandomNumber(30000));
+            values.push_back(i);
+        }
+        HashMap<int, int> expected(keys.begin(), keys.end(), values.begin(), values.end());
+        WorkStealingPool pool(4);
+        HashMap<int, int> built = HashMap<int, int>::build_parallel(pool, keys, values);
+        assert(built == expected && built.size() == expected.size());
+        for (auto it = expected.cbegin(); it != expected.cend(); ++it)
+        {
+            assert(built.at(it->first) == it->second);
+        }
+        WorkStealingPool one(1);
+        HashMap<int, int> single = HashMap<int, int>::build_parallel(one, keys, values);
+        assert(single == expected);
+        HashMap<int, int> none = HashMap<int, int>::build_parallel(pool, std::vector<int>(),
+                                                                   std::vector<int>());
+        assert(none.empty());
+        try
+        {
+            values.pop_back();
+            HashMap<int, int>::build_parallel(pool, keys, values);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass parallel build ======================" << std::endl;
+    std::cout << "====================== occupancy bitmap ======================" << std::endl;
+    try
+    {
+        HashMapPolicy noShrink;
+        noShrink.minLoadFactor = 0;
+        HashMap<int, int> sparse(noShrink);
+        for (int i = 0; i < 10000; i++)
+        {
+            sparse.insert(i, i);
+        }
+        for (int i = 0; i < 10000; i++)
+        {
+            if (i % 1000 != 7)
+            {
+                sparse.erase(i);
+            }
+        }
+        assert(sparse.size() == 10 && sparse.capacity() >= 8192);
+        int count = 0;
+        for (const auto &tuple : sparse)
+        {
+            assert(tuple.first % 1000 == 7 && tuple.second == tuple.first);
+            count++;
+        }
+        assert(count == 10);
+        // iterators refer to the stored pairs
+        auto it = sparse.find(2007);
+        const pair<int, int> &stored = *it;
+        const pair<int, int> &found = *sparse.find(2007);
+        assert(&stored == &found);
+        assert(&it->second == &sparse.find(2007)->second && it->second == 2007);
+        sparse[2007] = 5;
+        assert((*it).second == 5);
+
+        HashMap<int, int> incremental;
+        incremental.set_rehash_step(1);
+        for (int i = 0; i < 1000; i++)
+        {
+            incremental.insert(i, i);
+            count = 0;
+            for (auto node = incremental.begin(); node != incremental.end(); ++node)
+            {
+                count++;
+            }
+            assert(count == i + 1);
+        }
+        HashMap<int, int> copy(incremental);
+        HashMap<int, int> moved(std::move(copy));
+        assert(copy.begin() == copy.end() && std::distance(moved.begin(), moved.end()) == 1000);
+        copy.insert(1, 1);
+        assert(std::distance(copy.begin(), copy.end()) == 1);
+        copy.swap(moved);
+        assert(std::distance(copy.begin(), copy.end()) == 1000);
+        swap(copy, moved);
+        copy.clear();
+        assert(copy.begin() == copy.end());
+        WorkStealingPool pool(4);
+        moved.parallel_erase_if(pool, [](const pair<int, int> &tuple)
+        {
+            return tuple.first % 2 == 0;
+        });
+        count = 0;
+        for (const auto &tuple : moved)
+        {
+            assert(tuple.first % 2 == 1);
+            count++;
+        }
+        assert(count == 500 && (size_t) count == moved.size());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass occupancy bitmap ======================" << std::endl;
+    std::cout << "====================== mutable iterator ======================" << std::endl;
+    try
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 1000; i++)
+        {
+            map.insert(i, i);
+        }
+        for (auto &&tuple : map)
+        {
+            tuple.second *= 2;
+        }
+        // a key can only be read through an iterator, it decides the bucket of its pair
+        static_assert(!std::is_assignable<decltype((map.begin()->first)), int>::value, "");
+        static_assert(!std::is_assignable<decltype(((*map.begin()).first)), int>::value, "");
+        for (auto it = map.begin(); it != map.end(); it++)
+        {
+            assert(it->second == 2 * it->first);
+            it->second++;
+        }
+        assert(map.at(10) == 21);
+        HashMap<int, int>::const_iterator constIt = map.begin();
+        assert(constIt == map.cbegin());
+
+        // erasing while scanning keeps the capacity, and every element is visited once
+        size_t capacity = map.capacity();
+        int visited = 0;
+        for (auto it = map.begin(); it != map.end();)
+        {
+            visited++;
+            if (it->first % 10 != 0)
+            {
+                it = map.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        assert(visited == 1000 && map.size() == 100 && map.capacity() == capacity);
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(map.contains_key(i) == (i % 10 == 0));
+        }
+        auto next = map.erase(map.find(990));
+        assert(next == map.end() || next->first % 10 == 0);
+        assert(!map.contains_key(990) && map.size() == 99);
+
+        // erase_if shrinks once, at the end
+        HashMap<int, int> sweep;
+        sweep.set_rehash_step(4);
+        for (int i = 0; i < 5000; i++)
+        {
+            sweep.insert(i, i);
+        }
+        size_t erased = sweep.erase_if([](const pair<int, int> &tuple)
+                                       {
+                                           return tuple.second % 100 != 0;
+                                       });
+        assert(erased == 4950 && sweep.size() == 50 && sweep.capacity() < 5000);
+        for (int i = 0; i < 5000; i++)
+        {
+            assert(sweep.contains_key(i) == (i % 100 == 0));
+        }
+        assert(sweep.erase_if([](const pair<int, int> &)
+                              {
+                                  return false;
+                              }) == 0 && sweep.size() == 50);
+        assert(std::distance(sweep.begin(), sweep.end()) == 50);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass mutable iterator ======================" << std::endl;
+    std::cout << "====================== hash finalizer ======================" << std::endl;
+    try
+    {
+        HashMapPolicy policies[3];
+        policies[1].finalizer = HashMapFinalizer::FIBONACCI;
+        policies[2].finalizer = HashMapFinalizer::MURMUR;
+        for (int p = 0; p < 3; p++)
+        {
+            HashMap<int, int> strided(policies[p]);
+            for (int i = 0; i < 100; i++)
+            {
+                strided.insert(i * 1024, i);
+            }
+            std::set<size_t> buckets;
+            for (int i = 0; i < 100; i++)
+            {
+                buckets.insert(strided.bucket_index(i * 1024));
+            }
+            // the identity puts all keys in one bucket, a finalizer spreads them
+            assert(p == 0 ? buckets.size() == 1 : buckets.size() > 50);
+        }
+        HashMap<int, int> map;
+        map.set_rehash_step(2);
+        for (int i = 0; i < 3000; i++)
+        {
+            map.insert(i * 64, i);
+        }
+        map.set_policy(policies[2]);
+        assert(map.policy().finalizer == HashMapFinalizer::MURMUR && map.size() == 3000);
+        for (int i = 0; i < 3000; i++)
+        {
+            assert(map.at(i * 64) == i);
+        }
+        assert(std::distance(map.begin(), map.end()) == 3000);
+        HashMap<int, int> copy;
+        copy.insert(map.begin(), map.end());
+        assert(copy == map && copy.at(64) == 1);
+        std::vector<int> keys, values;
+        for (int i = 0; i < 5000; i++)
+        {
+            keys.push_back(i * 4096);
+            values.push_back(i);
+        }
+        WorkStealingPool pool(4);
+        HashMap<int, int> built = HashMap<int, int>::build_parallel(pool, keys, values, policies[1]);
+        assert(built.size() == 5000 && built.policy().finalizer == HashMapFinalizer::FIBONACCI);
+        for (int i = 0; i < 5000; i++)
+        {
+            assert(built.at(i * 4096) == i);
+        }
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass hash finalizer ======================" << std::endl;
+    std::cout << "====================== seeded hash ======================" << std::endl;
+    try
+    {
+        // reference vectors of SipHash-2-4
+        SipKey key{0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+        unsigned char message[15];
+        for (unsigned char i = 0; i < 15; i++)
+        {
+            message[i] = i;
+        }
+        assert(sipHash(message, 0, key) == 0x726fdb47dd0e0e31ULL);
+        assert(sipHash(message, 8, key) == 0x93f5f5799a932462ULL);
+        assert(sipHash(message, 15, key) == 0xa129ca6149be45e5ULL);
+
+        HashMapPolicy seeded;
+        seeded.finalizer = HashMapFinalizer::SIPHASH;
+        HashMap<std::string, int> first(seeded), second(seeded);
+        int moved = 0;
+        for (int i = 0; i < 200; i++)
+        {
+            first.insert("key" + std::to_string(i), i);
+            second.insert("key" + std::to_string(i), i);
+        }
+        for (int i = 0; i < 200; i++)
+        {
+            std::string name = "key" + std::to_string(i);
+            assert(first.at(name) == i && second.at(name) == i);
+            moved += first.bucket_index(name) != second.bucket_index(name);
+        }
+        // every map draws its own key
+        assert(moved > 0 && first == second);
+        HashMap<std::string, int> copy(first);
+        assert(copy == first && copy.bucket_index("key7") == first.bucket_index("key7"));
+
+        // a chain over the limit draws a new key, at most once per doubling of the size
+        seeded.maxChainLength = 1;
+        HashMap<int, int> watched(seeded);
+        watched.set_rehash_step(3);
+        for (int i = 0; i < 5000; i++)
+        {
+            auto res = watched.try_emplace(i * 1024, i);
+            assert(res.second && res.first->second == i);
+            assert(std::distance(res.first, watched.end()) <= (long) watched.size());
+        }
+        for (int i = 0; i < 5000; i++)
+        {
+            assert(watched.at(i * 1024) == i);
+        }
+        assert(std::distance(watched.begin(), watched.end()) == 5000);
+        HashMapPolicy unseeded;
+        watched.set_policy(unseeded);
+        assert(watched.bucket_index(1024) == 1024 % watched.capacity() && watched.at(2048) == 2);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass seeded hash ======================" << std::endl;
+    std::cout << "====================== custom hash and allocator ======================" << std::endl;
+    try
+    {
+        HashMap<std::string, int, CaseInsensitiveHash, CaseInsensitiveEqual> names;
+        assert(names.insert("Alice", 1) && !names.insert("ALICE", 2));
+        assert(names.at("alice") == 1 && names.contains_key("aLiCe") && names.size() == 1);
+        assert(names.erase("ALICE") && names.empty());
+
+        // empty functors and allocators take no space, a functor with a state does
+        assert(sizeof(HashMap<int, int, OffsetHash>) ==
+               sizeof(HashMap<int, int>) + sizeof(OffsetHash));
+        HashMap<int, int, OffsetHash> offset(HashMapPolicy{}, OffsetHash{5});
+        assert(offset.hash_function().offset == 5);
+        for (int i = 0; i < 100; i++)
+        {
+            offset.insert(i, i);
+        }
+        assert(offset.bucket_index(1) == 6 % offset.capacity() && offset.at(99) == 99);
+        HashMap<int, int, OffsetHash> offsetCopy(offset);
+        assert(offsetCopy.hash_function().offset == 5 && offsetCopy.at(42) == 42);
+
+        long live = 0;
+        {
+            typedef CountingAllocator<pair<int, int>> Allocator;
+            typedef HashMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> CountedMap;
+            Allocator allocator(&live);
+            CountedMap counted(allocator);
+            for (int i = 0; i < 1000; i++)
+            {
+                counted.insert(i, i);
+            }
+            // a node per element, the table and its occupancy bitmap
+            assert(live == 1002 && counted.get_allocator().live == &live);
+            counted.erase(0);
+            assert(live == 1001);
+            auto copy = counted;
+            assert(live == 2002 && copy == counted);
+            auto moved = std::move(copy);
+            assert(live == 2002 && moved.size() == 999);
+            long otherLive = 0;
+            Allocator otherAllocator(&otherLive);
+            CountedMap other(otherAllocator);
+            other.insert(1, 1);
+            // the allocator does not move, so the elements are moved one by one
+            other = std::move(moved);
+            assert(other.size() == 999 && other.get_allocator().live == &otherLive);
+            assert(otherLive == 1001 && live == 1003);
+            other.clear();
+            assert(otherLive == 2);
+        }
+        assert(live == 0);
+
+        // a moved from map holds an empty bucket of its own, not one of the first moved from map
+        long firstLive = 0;
+        long secondLive = 0;
+        {
+            typedef CountingAllocator<pair<int, int>> Allocator;
+            typedef HashMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> CountedMap;
+            Allocator secondAllocator(&secondLive);
+            CountedMap second(secondAllocator);
+            {
+                Allocator firstAllocator(&firstLive);
+                CountedMap first(firstAllocator);
+                first.insert(1, 1);
+                CountedMap taken(std::move(first));
+            }
+            assert(firstLive == 0);
+            second.insert(2, 2);
+            CountedMap taken(std::move(second));
+            assert(second.empty() && !second.contains_key(2) && second.begin() == second.end());
+            CountedMap empty(std::move(second));
+            second.swap(empty);
+            assert(second.empty() && empty.empty() && !empty.contains_key(2));
+            second.insert(3, 3);
+            empty.insert(4, 4);
+            assert(second.at(3) == 3 && empty.at(4) == 4 && secondLive == 9);
+        }
+        assert(secondLive == 0);
+
+        // an allocator that moves on move assignment goes with the tables, the old tables are
+        // freed by the allocator that allocated them
+        long sourceLive = 0;
+        long targetLive = 0;
+        {
+            typedef MovingCountingAllocator<pair<int, int>> Allocator;
+            typedef HashMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> MovingMap;
+            MovingMap target((Allocator(&targetLive)));
+            target.insert(1, 1);
+            {
+                MovingMap source((Allocator(&sourceLive)));
+                source.insert(2, 2);
+                target = std::move(source);
+                assert(target.get_allocator().live == &sourceLive && targetLive == 0);
+                assert(target.at(2) == 2 && !target.contains_key(1));
+            }
+            target.insert(3, 3);
+            assert(sourceLive == 4 && targetLive == 0);
+        }
+        assert(sourceLive == 0 && targetLive == 0);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass custom hash and allocator ======================" << std::endl;
+    std::cout << "====================== transparent lookup ======================" << std::endl;
+    try
+    {
+        // a Token does not convert to std::string, so these lookups cannot construct a key
+        std::string longKey(100, 'k');
+        Token longToken{longKey.data(), longKey.size()};
+        Token missing{"missing", 7};
+        HashMap<std::string, int, TokenHash, TokenEqual> tokens;
+        for (int i = 0; i < 100; i++)
+        {
+            tokens.insert(std::to_string(i), i);
+        }
+        tokens.insert(longKey, -1);
+        assert(tokens.contains_key(longToken) && !tokens.contains_key(missing));
+        assert(tokens.at(longToken) == -1 && tokens.find(Token{"42", 2})->second == 42);
+        assert(tokens.find(missing) == tokens.end());
+        assert(tokens.bucket_index(longToken) == tokens.bucket_index(longKey));
+        assert(tokens.bucket_size(longToken) == tokens.bucket_size(longKey));
+        tokens.at(Token{"7", 1}) = 70;
+        assert(tokens.at("7") == 70);
+        const HashMap<std::string, int, TokenHash, TokenEqual> &constTokens = tokens;
+        assert(constTokens.at(longToken) == -1 && constTokens.find(missing) == constTokens.end());
+        bool thrown = false;
+        try
+        {
+            tokens.at(missing);
+        }
+        catch (std::exception &e)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(tokens.erase(longToken) && !tokens.erase(longToken) && tokens.size() == 100);
+        // an iterator still erases through erase(const_iterator)
+        tokens.erase(tokens.find(Token{"0", 1}));
+        assert(tokens.size() == 99 && !tokens.contains_key(Token{"0", 1}));
+
+        // the seeded finalizer hashes what the transparent Hash returns, for keys and tokens alike
+        HashMapPolicy policy;
+        policy.finalizer = HashMapFinalizer::SIPHASH;
+        HashMap<std::string, int, TokenHash, TokenEqual> seeded(policy);
+        seeded.insert(longKey, 1);
+        assert(seeded.at(longToken) == 1 && seeded.erase(longToken) && seeded.empty());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass transparent lookup ======================" << std::endl;
+    std::cout << "====================== node pool ======================" << std::endl;
+    try
+    {
+        typedef NodePoolAllocator<pair<int, int>> Allocator;
+        NodePool pool;
+        Allocator allocator(pool);
+        PooledHashMap<int, int> pooled(allocator);
+        for (int i = 0; i < 10000; i++)
+        {
+            pooled.insert(i, i);
+        }
+        assert(pool.in_use() >= pooled.size() && pool.chunks() > 0);
+        // freed nodes are handed out again, so churn takes no new chunks
+        size_t chunks = pool.chunks();
+        for (int round = 0; round < 10; round++)
+        {
+            for (int i = 0; i < 5000; i++)
+            {
+                pooled.erase(i + round * 5000);
+                pooled.insert(i + (round + 2) * 5000, i);
+            }
+        }
+        assert(pooled.size() == 10000 && pooled.at(11 * 5000 + 7) == 7);
+        assert(pool.chunks() == chunks);
+
+        // copies and moved maps share the pool, nodes may be freed from several threads
+        {
+            PooledHashMap<int, int> copy(pooled);
+            assert(copy == pooled && &copy.get_allocator().pool() == &pool);
+            PooledHashMap<int, int> moved(std::move(copy));
+            assert(moved.size() == 10000 && pool.in_use() >= 20000);
+            WorkStealingPool workers(4);
+            moved.parallel_erase_if(workers, [](const pair<int, int> &tuple)
+                                    {
+                                        return tuple.first % 2 == 0;
+                                    });
+            assert(moved.size() == 5000 && moved.at(11 * 5000 + 7) == 7);
+            NodePool otherPool;
+            PooledHashMap<int, int> other((Allocator(otherPool)));
+            other.insert(1, 1);
+            // the pool moves along with the nodes
+            other = std::move(moved);
+            assert(other.size() == 5000 && &other.get_allocator().pool() == &pool);
+            assert(otherPool.in_use() == 0);
+        }
+
+        // clearing a map gives back every chunk no other map holds a block of (here the node and
+        // the bitmap of holder), and clearing the last one gives them all back
+        PooledHashMap<int, int> holder(allocator);
+        holder.insert(1, 1);
+        pooled.clear();
+        assert(pooled.empty() && pool.in_use() == 2 && pool.chunks() == 2);
+        {
+            PooledHashMap<int, int> last(std::move(holder));
+            assert(pool.chunks() > 0);
+        }
+        assert(pool.in_use() == 0 && pool.chunks() == 0);
+        for (int i = 0; i < 10000; i++)
+        {
+            pooled.insert(i, i);
+        }
+        pooled.clear();
+        assert(pool.in_use() == 0 && pool.chunks() == 0);
+
+        // a table shrunk small enough to come from the pool keeps only its own chunk
+        {
+            PooledHashMap<int, int> small(allocator);
+            small.insert(1, 1);
+            small.shrink_to_fit();
+            for (int i = 0; i < 10000; i++)
+            {
+                pooled.insert(i, i);
+            }
+            size_t held = pool.in_use() - pooled.size();
+            pooled.clear();
+            assert(pool.in_use() == held && pool.chunks() <= held);
+            // the table and its bitmap
+            small.clear();
+            assert(pool.in_use() == 2 && pool.chunks() == 2);
+        }
+        assert(pool.in_use() == 0 && pool.chunks() == 0);
+        pooled.insert(1, 1);
+        assert(pooled.at(1) == 1 && pool.chunks() == 1);
+
+        NodePoolAllocator<pair<std::string, std::string>> namesAllocator(pool);
+        PooledHashMap<std::string, std::string> names(namesAllocator);
+        names.insert(std::string(100, 'a'), "long");
+        names.insert("b", "short");
+        assert(names.at(std::string(100, 'a')) == "long" && names.at("b") == "short");
+
+        // a pooled map is built from ranges with its allocator, there is no default one
+        std::vector<int> keys = {1, 2, 3};
+        std::vector<int> values = {10, 20, 30};
+        PooledHashMap<int, int> ranged(keys.begin(), keys.end(), values.begin(), values.end(),
+                                       allocator);
+        assert(ranged.size() == 3 && ranged.at(2) == 20 && &ranged.get_allocator().pool() == &pool);
+        WorkStealingPool workers(4);
+        PooledHashMap<int, int> built = PooledHashMap<int, int>::build_parallel(
+                workers, keys, values, HashMapPolicy{}, allocator);
+        assert(built == ranged && &built.get_allocator().pool() == &pool);
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass node pool ======================" << std::endl;
+    std::cout << "====================== pmr ======================" << std::endl;
+    try
+    {
+        // a map on a stack buffer, with no upstream resource, never calls the heap - its tables,
+        // nodes and occupancy bitmaps all come from the buffer
+        alignas(std::max_align_t) char buffer[1 << 18];
+        {
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                                      std::pmr::null_memory_resource());
+            _heapCalls = 0;
+            _heapCounting = true;
+            {
+                pmr::HashMap<int, int> requests(&arena);
+                for (int i = 0; i < 1000; i++)
+                {
+                    requests.insert(i, i);
+                }
+                requests.clear();
+            }
+            _heapCounting = false;
+            assert(_heapCalls == 0);
+        }
+        {
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                                      std::pmr::null_memory_resource());
+            pmr::HashMap<int, int> requests(&arena);
+            for (int i = 0; i < 500; i++)
+            {
+                requests.insert(i, i * 2);
+            }
+            assert(requests.size() == 500 && requests.at(499) == 998);
+            assert(requests.get_allocator().resource() == &arena);
+            requests.clear();
+            assert(requests.empty() && !requests.contains_key(1));
+            requests.insert(1, 1);
+            assert(requests.at(1) == 1 && requests.size() == 1);
+        }
+
+        // clear and the destructor free no node of a monotonic resource
+        long deallocations = 0;
+        {
+            CountingMonotonicResource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+            {
+                pmr::HashMap<int, int> requests(&arena);
+                for (int i = 0; i < 500; i++)
+                {
+                    requests.insert(i, i);
+                }
+                // only the tables replaced on growing were freed
+                long grown = arena.deallocations;
+                requests.clear();
+                assert(arena.deallocations == grown);
+            }
+            deallocations = arena.deallocations;
+        }
+        assert(deallocations < 500);
+
+        // elements that are not trivially destructible are still destroyed
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+        pmr::HashMap<std::string, int> names(&arena);
+        names.insert(std::string(100, 'n'), 1);
+        names.clear();
+        assert(names.empty());
+
+        // other resources free every node
+        std::pmr::unsynchronized_pool_resource pool;
+        pmr::HashMap<int, int> pooled(&pool);
+        for (int i = 0; i < 1000; i++)
+        {
+            pooled.insert(i, i);
+        }
+        for (int i = 0; i < 1000; i += 2)
+        {
+            pooled.erase(i);
+        }
+        pmr::HashMap<int, int> copy(pooled);
+        assert(copy == pooled && copy.size() == 500 && copy.at(999) == 999);
+
+        // an unsynchronized resource is not allocated from by several threads at once, a parallel
+        // build links its nodes on the calling thread
+        std::pmr::synchronized_pool_resource shared;
+        assert(!hashMapConcurrent(pooled.get_allocator()));
+        assert(hashMapConcurrent(std::pmr::polymorphic_allocator<int>(&shared)));
+        assert(hashMapConcurrent(std::pmr::polymorphic_allocator<int>()));
+        std::vector<int> keys, values;
+        for (int i = 0; i < 10000; i++)
+        {
+            keys.push_back(i);
+            values.push_back(i * 3);
+        }
+        WorkStealingPool workers(4);
+        pmr::HashMap<int, int> built = pmr::HashMap<int, int>::build_parallel(
+                workers, keys, values, HashMapPolicy{}, &pool);
+        assert(built.size() == 10000 && built.at(9999) == 29997);
+        assert(built.get_allocator().resource() == &pool);
+        // and parallel_erase_if frees its nodes on the calling thread
+        size_t erased = built.parallel_erase_if(workers, [](const pair<int, int> &tuple)
+                                                {
+                                                    return tuple.first % 2 == 1;
+                                                });
+        assert(erased == 5000 && built.size() == 5000 && !built.contains_key(1));
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass pmr ======================" << std::endl;
+    std::cout << "====================== flat map ======================" << std::endl;
+    try
+    {
+        FlatHashMap<int, int> map(_keys.begin(), _keys.end(), _values.begin(), _values.end());
+        assert(map.size() == 13);
+        assert(map.capacity() == 16);
+        for (int i = 1; i < 14; i++)
+        {
+            assert(map.contains_key(i));
+            assert(map.at(i) == i);
+        }
+        assert(!map.contains_key(14));
+        try
+        {
+            map.at(-1);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        FlatHashMap<int, int> map1(map);
+        assert(map1 == map);
+        map1[14] = 14;
+        assert(map1 != map);
+        assert(map1.size() == 14);
+
+        std::map<int, int> realMap;
+        FlatHashMap<int, int> map2;
+        int num1, num2;
+        for (unsigned int i = 0; i < 5000; i++)
+        {
+            num1 = getRandomNumber(1000);
+            num2 = getRandomNumber(500);
+            if (i % 3 == 0)
+            {
+                assert(map2.erase(num1) == (realMap.erase(num1) == 1));
+            }
+            else
+            {
+                map2[num1] = num2;
+                realMap[num1] = num2;
+            }
+        }
+        assert(map2.size() == realMap.size());
+        int counter = 0;
+        for (auto it = map2.cbegin(); it != map2.cend(); ++it)
+        {
+            counter++;
+            assert(realMap.at(it->first) == it->second);
+        }
+        assert(counter == (int) realMap.size());
+        map2.clear();
+        assert(map2.empty());
+        assert(map2.cbegin() == map2.cend());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass flat map ======================" << std::endl;
+    std::cout << "====================== robin hood map ======================" << std::endl;
+    try
+    {
+        RobinHoodHashMap<int, int> map(_keys.begin(), _keys.end(), _values.begin(), _values.end());
+        assert(map.size() == 13);
+        assert(map.capacity() == 16);
+        for (int i = 1; i < 14; i++)
+        {
+            assert(map.at(i) == i);
+        }
+        assert(map.erase(5));
+        assert(!map.contains_key(5));
+        assert(!map.erase(5));
+        RobinHoodHashMap<int, int> map1 = map;
+        assert(map1 == map);
+
+        std::map<int, int> realMap;
+        RobinHoodHashMap<int, int> map2(0.95);
+        assert(map2.max_load_factor() == 0.95);
+        int num1, num2;
+        for (unsigned int i = 0; i < 5000; i++)
+        {
+            num1 = getRandomNumber(1000);
+            num2 = getRandomNumber(500);
+            if (i % 3 == 0)
+            {
+                assert(map2.erase(num1) == (realMap.erase(num1) == 1));
+            }
+            else
+            {
+                map2[num1] = num2;
+                realMap[num1] = num2;
+            }
+            assert(map2.load_factor() <= 0.95);
+        }
+        assert(map2.size() == realMap.size());
+        for (auto it : realMap)
+        {
+            assert(map2.at(it.first) == it.second);
+        }
+        int counter = 0;
+        for (auto it = map2.cbegin(); it != map2.cend(); it++)
+        {
+            counter++;
+            assert(realMap.at((*it).first) == (*it).second);
+        }
+        assert(counter == (int) realMap.size());
+    }
+    catch (...)
+    {
+        //should not arrive here
+        assert(false);
+    }
+    std::cout << "====================== pass robin hood map ======================" << std::endl;
 
     return EXIT_SUCCESS;
 }